@@ -16,9 +16,33 @@
 #include "OgreScriptLoader.h"
 #include "OgreResourceGroupManager.h"
 #include "OgreLogManager.h"
+#include "OgreString.h"
 
 #include "Ngf.h"
 
+//Only this file times things, so boost::chrono needn't be linked.
+#ifndef BOOST_CHRONO_HEADER_ONLY
+#define BOOST_CHRONO_HEADER_ONLY
+#endif
+#include "boost/chrono/chrono.hpp"
+
+#include "boost/thread/thread.hpp"
+#include "boost/thread/mutex.hpp"
+#include "boost/thread/shared_mutex.hpp"
+#include "boost/thread/locks.hpp"
+#include "boost/thread/condition_variable.hpp"
+#include "boost/thread/tss.hpp"
+
+#include "boost/cstdint.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <set>
+
 using namespace std;
 using namespace Ogre;
 
@@ -82,225 +106,4354 @@ namespace NGF {
                     start = values.find_first_not_of(delims, start);
                     ++numSplits;
 
-            } while (pos != Ogre::String::npos);
+            } while (pos != Ogre::String::npos);
+
+            insert(PropertyPair(key, vals));
+            return *this;
+    }
+    //----------------------------------------------------------------------------------
+    PropertyList PropertyList::create(Ogre::String key, Ogre::String values, Ogre::String delims)
+    {
+	    NGF::PropertyList props;
+	    props.addProperty(key, values, delims);
+	    return props;
+    }
+
+/*
+ * =====================================================================================
+ * NGF::FlagRegistry
+ * =====================================================================================
+ */
+
+    //The registries are used from parallel ticks too, so they're locked. Lookups share
+    //the lock, only adding a name takes it alone.
+    typedef boost::shared_lock<boost::shared_mutex> RegistryReadLock;
+    typedef boost::unique_lock<boost::shared_mutex> RegistryWriteLock;
+
+    //Function-local so flags can be made during static initialisation. The names are in
+    //a deque so the references getFlagName gives stay good as more are added.
+    typedef boost::unordered_map<Ogre::String, FlagID> FlagMap;
+
+    static FlagMap &flagMap()
+    {
+	    static FlagMap flags;
+	    return flags;
+    }
+    static std::deque<Ogre::String> &flagNames()
+    {
+	    static std::deque<Ogre::String> names;
+	    return names;
+    }
+    static boost::shared_mutex &flagMutex()
+    {
+	    static boost::shared_mutex mutex;
+	    return mutex;
+    }
+    //----------------------------------------------------------------------------------
+    FlagID FlagRegistry::getFlag(const Ogre::String &name)
+    {
+	    FlagID flag;
+	    if (findFlag(name, flag))
+	    {
+		    return flag;
+	    }
+
+	    RegistryWriteLock lock(flagMutex());
+
+	    //It might have been made since we looked.
+	    FlagMap::iterator iter = flagMap().find(name);
+	    if (iter != flagMap().end())
+	    {
+		    return iter->second;
+	    }
+
+	    std::deque<Ogre::String> &names = flagNames();
+	    if (names.size() >= NGF_MAX_FLAGS)
+	    {
+		    OGRE_EXCEPT(Ogre::Exception::ERR_INVALID_STATE, "Too many flags (" + name 
+				    + ")! Define NGF_MAX_FLAGS to have more.", "NGF::FlagRegistry::getFlag()");
+	    }
+
+	    flag = names.size();
+	    names.push_back(name);
+	    flagMap()[name] = flag;
+
+	    return flag;
+    }
+    //----------------------------------------------------------------------------------
+    bool FlagRegistry::findFlag(const Ogre::String &name, FlagID &flag)
+    {
+	    RegistryReadLock lock(flagMutex());
+	    FlagMap::const_iterator iter = flagMap().find(name);
+
+	    if (iter == flagMap().end())
+	    {
+		    return false;
+	    }
+
+	    flag = iter->second;
+	    return true;
+    }
+    //----------------------------------------------------------------------------------
+    const Ogre::String &FlagRegistry::getFlagName(FlagID flag)
+    {
+	    RegistryReadLock lock(flagMutex());
+	    return flagNames().at(flag);
+    }
+    //----------------------------------------------------------------------------------
+    unsigned int FlagRegistry::getNumFlags()
+    {
+	    RegistryReadLock lock(flagMutex());
+	    return flagNames().size();
+    }
+
+/*
+ * =====================================================================================
+ * NGF::MessageRegistry
+ * =====================================================================================
+ */
+
+    typedef boost::unordered_map<Ogre::String, unsigned int> MessageCodeMap;
+    typedef boost::unordered_map<unsigned int, Ogre::String> MessageNameMap;
+
+    static MessageCodeMap &messageCodes()
+    {
+	    static MessageCodeMap codes;
+	    return codes;
+    }
+    static MessageNameMap &messageNames()
+    {
+	    static MessageNameMap names;
+	    return names;
+    }
+    static unsigned int &nextMessageCode()
+    {
+	    static unsigned int next = NGF_MSG_INTERNED_BASE;
+	    return next;
+    }
+    static boost::shared_mutex &messageMutex()
+    {
+	    static boost::shared_mutex mutex;
+	    return mutex;
+    }
+    //----------------------------------------------------------------------------------
+    unsigned int MessageRegistry::getCode(const Ogre::String &name)
+    {
+	    unsigned int code = 0;
+	    if (name.empty() || findCode(name, code))
+	    {
+		    return code;
+	    }
+
+	    RegistryWriteLock lock(messageMutex());
+
+	    //It might have been given one since we looked.
+	    MessageCodeMap::iterator iter = messageCodes().find(name);
+	    if (iter != messageCodes().end())
+	    {
+		    return iter->second;
+	    }
+
+	    code = nextMessageCode()++;
+	    messageCodes()[name] = code;
+	    messageNames()[code] = name;
+
+	    return code;
+    }
+    //----------------------------------------------------------------------------------
+    bool MessageRegistry::findCode(const Ogre::String &name, unsigned int &code)
+    {
+	    RegistryReadLock lock(messageMutex());
+	    MessageCodeMap::const_iterator iter = messageCodes().find(name);
+
+	    if (iter == messageCodes().end())
+	    {
+		    return false;
+	    }
+
+	    code = iter->second;
+	    return true;
+    }
+    //----------------------------------------------------------------------------------
+    const Ogre::String &MessageRegistry::getName(unsigned int code)
+    {
+	    static const Ogre::String none;
+	    RegistryReadLock lock(messageMutex());
+	    MessageNameMap::const_iterator iter = messageNames().find(code);
+
+	    return iter == messageNames().end() ? none : iter->second;
+    }
+    //----------------------------------------------------------------------------------
+    void MessageRegistry::registerName(const Ogre::String &name, unsigned int code)
+    {
+	    RegistryWriteLock lock(messageMutex());
+	    MessageCodeMap::iterator byName = messageCodes().find(name);
+	    MessageNameMap::iterator byCode = messageNames().find(code);
+
+	    if (byName != messageCodes().end() && byName->second == code)
+	    {
+		    return;
+	    }
+
+	    if (name.empty() || code == 0 || byName != messageCodes().end() || byCode != messageNames().end())
+	    {
+		    OGRE_EXCEPT(Ogre::Exception::ERR_DUPLICATE_ITEM, "Message name '" + name + "' or code " 
+				    + Ogre::StringConverter::toString(code) + " already taken!", 
+				    "NGF::MessageRegistry::registerName()");
+	    }
+
+	    messageCodes()[name] = code;
+	    messageNames()[code] = name;
+    }
+    //----------------------------------------------------------------------------------
+    unsigned int MessageRegistry::_newTypedCode()
+    {
+	    static unsigned int next = NGF_MSG_TYPED_BASE;
+	    RegistryWriteLock lock(messageMutex());
+	    return next++;
+    }
+
+/*
+ * =====================================================================================
+ * NGF::MessageParam
+ * =====================================================================================
+ */
+
+    boost::any MessageParam::toAny() const
+    {
+	    switch (mType)
+	    {
+	    case PARAM_FLOAT:
+		    return boost::any(mData.f);
+	    case PARAM_DOUBLE:
+		    return boost::any(mData.d);
+	    case PARAM_INT:
+		    return boost::any(mData.i);
+	    case PARAM_UINT:
+		    return boost::any(mData.u);
+	    case PARAM_BOOL:
+		    return boost::any(mData.b);
+	    case PARAM_OBJECT:
+		    return boost::any(mData.obj);
+	    case PARAM_VECTOR3:
+		    return boost::any(get<Ogre::Vector3>());
+	    case PARAM_QUATERNION:
+		    return boost::any(get<Ogre::Quaternion>());
+	    case PARAM_ANY:
+		    return *mData.any;
+	    default:
+		    return boost::any();
+	    }
+    }
+
+/*
+ * =====================================================================================
+ * NGF::GameObject
+ * =====================================================================================
+ */
+
+    GameObject::~GameObject()
+    {
+	    //A constructor that subscribed or scheduled tasks and then threw never got us into
+	    //the manager, nothing else will end them.
+	    if (!mSubscriptions.empty() || mFirstTask != ~0u)
+	    {
+		    GameObjectManager::getSingleton()._forgetObject(this);
+	    }
+    }
+    //----------------------------------------------------------------------------------
+    bool GameObject::removeFlag(const Ogre::String &flag)
+    {
+	    FlagID id;
+	    return FlagRegistry::findFlag(flag, id) && removeFlag(id);
+    }
+    //----------------------------------------------------------------------------------
+    GameObject* GameObject::addFlag(FlagID flag)
+    {
+	    if (!mFlags.test(flag))
+	    {
+		    mFlags.set(flag);
+
+		    if (mManaged)
+		    {
+			    GameObjectManager::getSingleton()._addToFlagIndex(this, flag);
+		    }
+	    }
+
+	    return this;
+    }
+    //----------------------------------------------------------------------------------
+    bool GameObject::removeFlag(FlagID flag)
+    {
+	    if (!mFlags.test(flag))
+	    {
+		    return false;
+	    }
+
+	    mFlags.reset(flag);
+
+	    if (mManaged)
+	    {
+		    GameObjectManager::getSingleton()._removeFromFlagIndex(this, flag);
+	    }
+
+	    return true;
+    }
+    //----------------------------------------------------------------------------------
+    bool GameObject::hasFlag(const Ogre::String &flag) const
+    {
+	    FlagID id;
+	    return FlagRegistry::findFlag(flag, id) && mFlags.test(id);
+    }
+    //----------------------------------------------------------------------------------
+    Ogre::String GameObject::getFlags() const
+    {
+	    Ogre::String flags;
+
+	    for (FlagID i = 0; i < NGF_MAX_FLAGS; ++i)
+	    {
+		    if (mFlags.test(i))
+		    {
+			    flags += (flags.empty() ? "|" : "") + FlagRegistry::getFlagName(i) + "|";
+		    }
+	    }
+
+	    return flags;
+    }
+    //----------------------------------------------------------------------------------
+    void GameObject::setTickFlags(unsigned int flags)
+    {
+	    //Before we're managed (in the constructor) we just remember the flags.
+	    if (mManaged)
+	    {
+		    GameObjectManager::getSingleton()._setTickFlags(this, flags);
+	    }
+	    else
+	    {
+		    mTickFlags = flags;
+	    }
+    }
+    //----------------------------------------------------------------------------------
+    void GameObject::setTickInterval(unsigned int frames)
+    {
+	    if (mManaged)
+	    {
+		    GameObjectManager::getSingleton()._setTickInterval(this, frames);
+	    }
+	    else
+	    {
+		    mTickInterval = frames;
+	    }
+    }
+    //----------------------------------------------------------------------------------
+    void GameObject::setDeferrableTick(bool deferrable, int priority)
+    {
+	    if (mManaged)
+	    {
+		    GameObjectManager::getSingleton()._setDeferrableTick(this, deferrable, priority);
+	    }
+	    else
+	    {
+		    mTickDeferrable = deferrable;
+		    mTickPriority = priority;
+	    }
+    }
+    //----------------------------------------------------------------------------------
+    bool GameObject::isTickDeferrable() const
+    {
+	    if (mManaged)
+	    {
+		    return GameObjectManager::getSingleton()._isTickDeferrable(this);
+	    }
+	    return mTickDeferrable > 0;
+    }
+    //----------------------------------------------------------------------------------
+    int GameObject::getTickPriority() const
+    {
+	    if (mManaged)
+	    {
+		    return GameObjectManager::getSingleton()._getTickPriority(this);
+	    }
+	    return mTickPriority;
+    }
+
+/*
+ * =====================================================================================
+ * NGF::GameObjectFactory
+ * =====================================================================================
+ */
+
+    GameObjectFactory& GameObjectFactory::getSingleton(void)
+    {
+	    assert(msSingleton); return *msSingleton;
+    }
+    GameObjectFactory* GameObjectFactory::getSingletonPtr(void)
+    {
+	    return msSingleton;
+    }
+    //----------------------------------------------------------------------------------
+    GameObject* GameObjectFactory::createObject(Ogre::String type, Ogre::Vector3 pos, Ogre::Quaternion rot, PropertyList props, Ogre::String name)
+    {
+	    CreateFunctionMap::iterator iter = mCreateFunctions.find(type);
+
+	    if (iter != mCreateFunctions.end())
+		    return iter->second(pos, rot, props, name); //Found.
+	    return 0; //Not found.
+    }
+    //----------------------------------------------------------------------------------
+    GameObject* GameObjectFactory::_createObject(Ogre::String type, ID id, Ogre::Vector3 pos, Ogre::Quaternion rot, PropertyList props, Ogre::String name)
+    {
+	    IDCreateFunctionMap::iterator iter = mIDCreateFunctions.find(type);
+
+	    if (iter != mIDCreateFunctions.end())
+		    return iter->second(id, pos, rot, props, name); //Found.
+	    return 0; //Not found.
+    }
+    //----------------------------------------------------------------------------------
+    GameObjectFactory::IDCreateFunction GameObjectFactory::_getIDCreateFunction(const Ogre::String &type) const
+    {
+	    IDCreateFunctionMap::const_iterator iter = mIDCreateFunctions.find(type);
+
+	    if (iter != mIDCreateFunctions.end())
+		    return iter->second; //Found.
+	    return IDCreateFunction(); //Not found.
+    }
+
+/*
+ * =====================================================================================
+ * NGF::WorkerPool
+ * =====================================================================================
+ */
+
+    //Some work split into numbered items. 'run' is called with ranges of items, on the
+    //thread with the given worker index (0 is the thread that called WorkerPool::run).
+    class WorkerJob
+    {
+    public:
+	    virtual ~WorkerJob() { }
+	    virtual void run(unsigned int begin, unsigned int end, unsigned int worker) = 0;
+    };
+
+    //Threads that split WorkerJobs between them. Each worker starts with an equal part of
+    //the items and takes 'grain' at a time from the front of it. When it runs out, it 
+    //steals the back half of what another worker has left.
+    class WorkerPool
+    {
+    protected:
+	    struct Range
+	    {
+		    boost::mutex mutex;
+		    unsigned int begin, end;
+
+		    Range() : begin(0), end(0) { }
+	    };
+
+	    std::vector<boost::thread*> mThreads;
+	    std::vector<Range*> mRanges;
+	    unsigned int mGrain;
+
+	    boost::mutex mMutex;
+	    boost::condition_variable mStartCond, mDoneCond;
+	    unsigned int mJobNumber;
+	    unsigned int mBusyThreads;
+	    bool mQuit;
+	    WorkerJob *mJob;
+	    Ogre::String mError;
+
+	    void _threadMain(unsigned int worker);
+	    bool _take(unsigned int worker, unsigned int &begin, unsigned int &end);
+	    void _work(unsigned int worker);
+
+    public:
+	    WorkerPool(unsigned int numWorkers, unsigned int grain);
+	    ~WorkerPool();
+
+	    unsigned int getNumWorkers() const { return mRanges.size(); }
+
+	    //Runs the job on all workers, the calling thread being worker 0. Returns once all
+	    //items are done. Exceptions thrown in the job are passed on as an Ogre::Exception.
+	    void run(WorkerJob *job, unsigned int numItems);
+    };
+    //----------------------------------------------------------------------------------
+    WorkerPool::WorkerPool(unsigned int numWorkers, unsigned int grain)
+	    : mGrain(grain ? grain : 1),
+	      mJobNumber(0),
+	      mBusyThreads(0),
+	      mQuit(false),
+	      mJob(0)
+    {
+	    for (unsigned int i = 0; i < numWorkers; ++i)
+	    {
+		    mRanges.push_back(new Range());
+	    }
+
+	    //Worker 0 is the calling thread.
+	    for (unsigned int i = 1; i < numWorkers; ++i)
+	    {
+		    mThreads.push_back(new boost::thread(&WorkerPool::_threadMain, this, i));
+	    }
+    }
+    //----------------------------------------------------------------------------------
+    WorkerPool::~WorkerPool()
+    {
+	    {
+		    boost::mutex::scoped_lock lock(mMutex);
+		    mQuit = true;
+	    }
+	    mStartCond.notify_all();
+
+	    for (unsigned int i = 0; i < mThreads.size(); ++i)
+	    {
+		    mThreads[i]->join();
+		    delete mThreads[i];
+	    }
+	    for (unsigned int i = 0; i < mRanges.size(); ++i)
+	    {
+		    delete mRanges[i];
+	    }
+    }
+    //----------------------------------------------------------------------------------
+    void WorkerPool::run(WorkerJob *job, unsigned int numItems)
+    {
+	    //Split the items evenly.
+	    unsigned int numWorkers = mRanges.size();
+	    for (unsigned int i = 0; i < numWorkers; ++i)
+	    {
+		    boost::mutex::scoped_lock lock(mRanges[i]->mutex);
+		    mRanges[i]->begin = (unsigned int) ((unsigned long long) numItems * i / numWorkers);
+		    mRanges[i]->end = (unsigned int) ((unsigned long long) numItems * (i + 1) / numWorkers);
+	    }
+
+	    {
+		    boost::mutex::scoped_lock lock(mMutex);
+		    mJob = job;
+		    mError.clear();
+		    mBusyThreads = mThreads.size();
+		    ++mJobNumber;
+	    }
+	    mStartCond.notify_all();
+
+	    _work(0);
+
+	    Ogre::String error;
+	    {
+		    boost::mutex::scoped_lock lock(mMutex);
+		    while (mBusyThreads)
+		    {
+			    mDoneCond.wait(lock);
+		    }
+
+		    mJob = 0;
+		    error = mError;
+	    }
+
+	    if (!error.empty())
+	    {
+		    OGRE_EXCEPT(Ogre::Exception::ERR_INTERNAL_ERROR, "Exception in parallel tick: " + error, 
+				    "NGF::WorkerPool::run()");
+	    }
+    }
+    //----------------------------------------------------------------------------------
+    void WorkerPool::_threadMain(unsigned int worker)
+    {
+	    unsigned int lastJob = 0;
+
+	    while (true)
+	    {
+		    {
+			    boost::mutex::scoped_lock lock(mMutex);
+			    while (mJobNumber == lastJob && !mQuit)
+			    {
+				    mStartCond.wait(lock);
+			    }
+
+			    if (mQuit)
+			    {
+				    return;
+			    }
+			    lastJob = mJobNumber;
+		    }
+
+		    _work(worker);
+
+		    {
+			    boost::mutex::scoped_lock lock(mMutex);
+			    if (--mBusyThreads == 0)
+			    {
+				    mDoneCond.notify_all();
+			    }
+		    }
+	    }
+    }
+    //----------------------------------------------------------------------------------
+    bool WorkerPool::_take(unsigned int worker, unsigned int &begin, unsigned int &end)
+    {
+	    unsigned int numWorkers = mRanges.size();
+
+	    //Steal until we have something. Once everyone is empty there's nothing left to do.
+	    for (unsigned int i = 0; i < numWorkers; ++i)
+	    {
+		    Range *own = mRanges[worker];
+		    {
+			    boost::mutex::scoped_lock lock(own->mutex);
+			    if (own->begin < own->end)
+			    {
+				    begin = own->begin;
+				    end = std::min(own->begin + mGrain, own->end);
+				    own->begin = end;
+				    return true;
+			    }
+		    }
+
+		    Range *victim = mRanges[(worker + i + 1) % numWorkers];
+		    unsigned int stolenBegin, stolenEnd;
+		    {
+			    boost::mutex::scoped_lock lock(victim->mutex);
+			    if (victim->begin >= victim->end)
+			    {
+				    continue;
+			    }
+
+			    stolenEnd = victim->end;
+			    stolenBegin = victim->end - (victim->end - victim->begin + 1) / 2;
+			    victim->end = stolenBegin;
+		    }
+
+		    //Our range is empty so no one steals from it, we can just set it.
+		    boost::mutex::scoped_lock lock(own->mutex);
+		    own->begin = stolenBegin;
+		    own->end = stolenEnd;
+		    i = (unsigned int) -1;
+	    }
+
+	    return false;
+    }
+    //----------------------------------------------------------------------------------
+    void WorkerPool::_work(unsigned int worker)
+    {
+	    unsigned int begin, end;
+
+	    while (_take(worker, begin, end))
+	    {
+		    try
+		    {
+			    mJob->run(begin, end, worker);
+		    }
+		    catch (std::exception &e)
+		    {
+			    boost::mutex::scoped_lock lock(mMutex);
+			    if (mError.empty())
+				    mError = e.what();
+		    }
+		    catch (...)
+		    {
+			    boost::mutex::scoped_lock lock(mMutex);
+			    if (mError.empty())
+				    mError = "Unknown exception";
+		    }
+	    }
+    }
+
+/*
+ * =====================================================================================
+ * NGF::CommandBuffer
+ * =====================================================================================
+ */
+
+    //Calls made from a parallel tick, to be done after the parallel part.
+    struct CommandBuffer
+    {
+	    struct Command
+	    {
+		    enum Type
+		    {
+			    CREATE,
+			    DESTROY,
+			    REQUEST_DESTROY,
+			    SEND_MESSAGE,
+			    POST_MESSAGE
+		    };
+
+		    Type type;
+
+		    //Where the GameObject making the call is in the serial tick order.
+		    unsigned int item;
+
+		    ID id;
+		    fastdelegate::FastDelegate<GameObject* (Ogre::Vector3, Ogre::Quaternion, PropertyList, Ogre::String)> 
+			    create;
+		    Ogre::Vector3 pos;
+		    Ogre::Quaternion rot;
+		    PropertyList properties;
+		    Ogre::String name;
+		    Message msg;
+
+		    Command(Type t, unsigned int it)
+			    : type(t), item(it), id(0), msg(0u)
+		    {
+		    }
+
+		    bool operator<(const Command &other) const { return item < other.item; }
+	    };
+
+	    std::vector<Command> commands;
+	    unsigned int currItem;
+
+	    //The commands being run, swapped out of 'commands'.
+	    std::vector<Command> running;
+
+	    CommandBuffer() : currItem(0) { }
+
+	    Command &add(Command::Type type) 
+	    { 
+		    commands.push_back(Command(type, currItem)); 
+		    return commands.back(); 
+	    }
+    };
+
+    //The CommandBuffer of the thread, if it's running a parallel tick. It's not owned.
+    static void noCleanup(CommandBuffer *) { }
+    static boost::thread_specific_ptr<CommandBuffer> currCommandBuffer(noCleanup);
+
+    //Ticks a range of GameObjectManager::mParallelItems.
+    class ParallelTickJob : public WorkerJob
+    {
+    protected:
+	    GameObjectManager *mManager;
+
+    public:
+	    ParallelTickJob(GameObjectManager *mgr)
+		    : mManager(mgr)
+	    {
+	    }
+
+	    void run(unsigned int begin, unsigned int end, unsigned int worker)
+	    {
+		    CommandBuffer *cmds = mManager->mCommandBuffers[worker];
+		    currCommandBuffer.reset(cmds);
+
+		    //When profiling, each run of GameObjects of one type is timed.
+#ifdef NGF_ENABLE_PROFILER
+		    const bool profiling = ProfileScope::isEnabled();
+#else
+		    const bool profiling = false;
+#endif
+		    unsigned int runType = ProfileScope::NO_TYPE, runBegin = begin;
+		    double runStart = 0;
+
+		    for (unsigned int i = begin; i < end; ++i)
+		    {
+			    GameObjectManager::ParallelItem &item = mManager->mParallelItems[i];
+
+			    if (profiling && item.typeIndex != runType)
+			    {
+				    double now = ProfileScope::_now();
+				    if (i > runBegin)
+				    {
+					    ProfileScope::_record(runType, PROFILE_TICK, 0, runStart, now, i - runBegin, worker);
+				    }
+				    runType = item.typeIndex;
+				    runBegin = i;
+				    runStart = now;
+			    }
+
+			    cmds->currItem = i;
+			    item.obj->unpausedTick(item.evt);
+		    }
+
+		    if (profiling && end > runBegin)
+		    {
+			    ProfileScope::_record(runType, PROFILE_TICK, 0, runStart, ProfileScope::_now(), end - runBegin, worker);
+		    }
+
+		    currCommandBuffer.reset(0);
+	    }
+    };
+
+    //Replies given with GameObjectManager::fulfilRequest, which can be called from any
+    //thread. 'taken' is used by the main thread to go through them.
+    struct ReplyQueue
+    {
+	    typedef std::vector<std::pair<RequestTicket, MessageReply> > Replies;
+
+	    boost::mutex mutex;
+	    Replies replies;
+	    Replies taken;
+    };
+
+    //Tasks in a hierarchical timing wheel. Time goes in steps. Level L has NUM_SLOTS slots
+    //of NUM_SLOTS^L steps each. A task goes in the lowest level where it is due within the
+    //same slot of the level above as the current step, and moves down when the current
+    //step reaches the start of its slot, so each task moves at most NUM_LEVELS times. The
+    //slots, and the tasks of each owner, are lists threaded through the task array.
+    class TaskWheel
+    {
+    protected:
+	    enum
+	    {
+		    SLOT_BITS = 6,
+		    NUM_SLOTS = 1 << SLOT_BITS,
+		    NUM_LEVELS = 5,
+
+		    //Tasks due after the top level comes round wait here.
+		    OVERFLOW_LIST = NUM_LEVELS * NUM_SLOTS,
+		    NUM_LISTS
+	    };
+
+	    //'list' of free tasks, and of tasks taken out of their slot to be called.
+	    static const unsigned int NONE = ~0u;
+	    static const unsigned int FIRING = ~0u - 1;
+
+	    struct Task
+	    {
+		    TaskFunction func;
+		    GameObject *owner;
+		    boost::uint64_t due;
+		    unsigned int list;
+		    unsigned int prev, next;
+		    unsigned int ownerPrev, ownerNext;
+		    unsigned int generation;
+
+		    Task() : owner(0), due(0), list(NONE), prev(NONE), next(NONE), 
+			ownerPrev(NONE), ownerNext(NONE), generation(0) { }
+	    };
+
+	    std::vector<Task> mTasks;
+	    std::vector<unsigned int> mFree;
+	    unsigned int mHeads[NUM_LISTS];
+	    unsigned int mTails[NUM_LISTS];
+	    unsigned int mNumTasks;
+
+	    boost::uint64_t mNow;
+	    Ogre::Real mResolution;
+	    Ogre::Real mRemainder;
+
+	    std::vector<unsigned int> mFiring;
+	    bool mAdvancing;
+
+	    void _insert(unsigned int index)
+	    {
+		    Task &task = mTasks[index];
+
+		    task.list = OVERFLOW_LIST;
+		    for (unsigned int level = 0; level < NUM_LEVELS; ++level)
+		    {
+			    unsigned int shift = level * SLOT_BITS;
+			    if ((task.due >> (shift + SLOT_BITS)) == (mNow >> (shift + SLOT_BITS)))
+			    {
+				    task.list = level * NUM_SLOTS + (unsigned int) ((task.due >> shift) & (NUM_SLOTS - 1));
+				    break;
+			    }
+		    }
+
+		    task.next = NONE;
+		    task.prev = mTails[task.list];
+		    if (task.prev != NONE)
+			    mTasks[task.prev].next = index;
+		    else
+			    mHeads[task.list] = index;
+		    mTails[task.list] = index;
+	    }
+
+	    void _unlink(unsigned int index)
+	    {
+		    Task &task = mTasks[index];
+
+		    if (task.prev != NONE)
+			    mTasks[task.prev].next = task.next;
+		    else
+			    mHeads[task.list] = task.next;
+		    if (task.next != NONE)
+			    mTasks[task.next].prev = task.prev;
+		    else
+			    mTails[task.list] = task.prev;
+	    }
+
+	    void _free(unsigned int index)
+	    {
+		    Task &task = mTasks[index];
+
+		    if (task.owner)
+		    {
+			    if (task.ownerPrev != NONE)
+				    mTasks[task.ownerPrev].ownerNext = task.ownerNext;
+			    else
+				    task.owner->mFirstTask = task.ownerNext;
+			    if (task.ownerNext != NONE)
+				    mTasks[task.ownerNext].ownerPrev = task.ownerPrev;
+		    }
+
+		    task.func = TaskFunction();
+		    task.owner = 0;
+		    task.list = NONE;
+		    ++task.generation;
+		    mFree.push_back(index);
+		    --mNumTasks;
+	    }
+
+	    //Take a slot's tasks out and put them back in, which moves them down a level.
+	    void _cascade(unsigned int list)
+	    {
+		    unsigned int index = mHeads[list];
+		    mHeads[list] = mTails[list] = NONE;
+
+		    while (index != NONE)
+		    {
+			    unsigned int next = mTasks[index].next;
+			    _insert(index);
+			    index = next;
+		    }
+	    }
+
+	    void _step()
+	    {
+		    ++mNow;
+
+		    if ((mNow & (((boost::uint64_t) 1 << (NUM_LEVELS * SLOT_BITS)) - 1)) == 0)
+		    {
+			    _cascade(OVERFLOW_LIST);
+		    }
+		    for (unsigned int level = NUM_LEVELS - 1; level > 0; --level)
+		    {
+			    unsigned int shift = level * SLOT_BITS;
+			    if ((mNow & (((boost::uint64_t) 1 << shift) - 1)) == 0)
+			    {
+				    _cascade(level * NUM_SLOTS + (unsigned int) ((mNow >> shift) & (NUM_SLOTS - 1)));
+			    }
+		    }
+
+		    unsigned int slot = (unsigned int) (mNow & (NUM_SLOTS - 1));
+		    if (mHeads[slot] == NONE)
+		    {
+			    return;
+		    }
+
+		    //The tasks are taken out first so they can schedule and cancel freely.
+		    for (unsigned int index = mHeads[slot]; index != NONE; index = mTasks[index].next)
+		    {
+			    mTasks[index].list = FIRING;
+			    mFiring.push_back(index);
+		    }
+		    mHeads[slot] = mTails[slot] = NONE;
+
+		    unsigned int i = 0;
+		    try
+		    {
+			    for (; i < mFiring.size(); ++i)
+			    {
+				    unsigned int index = mFiring[i];
+				    if (mTasks[index].list != FIRING)
+				    {
+					    continue; //Cancelled by an earlier one.
+				    }
+
+				    TaskFunction func = mTasks[index].func;
+				    TaskHandle handle(index, mTasks[index].generation);
+				    _free(index);
+				    func(handle);
+			    }
+		    }
+		    catch (...)
+		    {
+			    //Those not called yet are due next step.
+			    for (++i; i < mFiring.size(); ++i)
+			    {
+				    if (mTasks[mFiring[i]].list == FIRING)
+				    {
+					    mTasks[mFiring[i]].due = mNow + 1;
+					    _insert(mFiring[i]);
+				    }
+			    }
+			    mFiring.clear();
+			    throw;
+		    }
+		    mFiring.clear();
+	    }
+
+    public:
+	    TaskWheel(Ogre::Real resolution)
+		    : mNumTasks(0),
+		      mNow(0),
+		      mResolution(resolution),
+		      mRemainder(0),
+		      mAdvancing(false)
+	    {
+		    std::fill(mHeads, mHeads + NUM_LISTS, NONE);
+		    std::fill(mTails, mTails + NUM_LISTS, NONE);
+	    }
+
+	    TaskHandle schedule(Ogre::Real delay, TaskFunction func, GameObject *owner)
+	    {
+		    //Due on the first step at or after the time, but never the current one. Far
+		    //enough is forever.
+		    Ogre::Real steps = std::ceil((mRemainder + std::max(delay, Ogre::Real(0))) / mResolution);
+		    boost::uint64_t ahead = steps < 1 ? 1 : steps > 1e15 ? (boost::uint64_t) 1e15 : (boost::uint64_t) steps;
+
+		    unsigned int index;
+		    if (mFree.empty())
+		    {
+			    index = mTasks.size();
+			    mTasks.push_back(Task());
+		    }
+		    else
+		    {
+			    index = mFree.back();
+			    mFree.pop_back();
+		    }
+
+		    Task &task = mTasks[index];
+		    task.func = func;
+		    task.owner = owner;
+		    task.due = mNow + ahead;
+		    _insert(index);
+
+		    if (owner)
+		    {
+			    task.ownerPrev = NONE;
+			    task.ownerNext = owner->mFirstTask;
+			    if (task.ownerNext != NONE)
+				    mTasks[task.ownerNext].ownerPrev = index;
+			    owner->mFirstTask = index;
+		    }
+
+		    ++mNumTasks;
+		    return TaskHandle(index, task.generation);
+	    }
+
+	    bool isPending(const TaskHandle &handle) const
+	    {
+		    return handle.index < mTasks.size() && mTasks[handle.index].list != NONE
+			    && mTasks[handle.index].generation == handle.generation;
+	    }
+
+	    bool cancel(const TaskHandle &handle)
+	    {
+		    if (!isPending(handle))
+		    {
+			    return false;
+		    }
+
+		    if (mTasks[handle.index].list != FIRING)
+		    {
+			    _unlink(handle.index);
+		    }
+		    _free(handle.index);
+		    return true;
+	    }
+
+	    void cancelOwned(GameObject *owner)
+	    {
+		    while (owner->mFirstTask != NONE)
+		    {
+			    unsigned int index = owner->mFirstTask;
+			    if (mTasks[index].list != FIRING)
+			    {
+				    _unlink(index);
+			    }
+			    _free(index);
+		    }
+	    }
+
+	    Ogre::Real getTimeLeft(const TaskHandle &handle) const
+	    {
+		    if (!isPending(handle))
+		    {
+			    return -1;
+		    }
+
+		    //Tasks being called are due now.
+		    const Task &task = mTasks[handle.index];
+		    if (task.list == FIRING)
+		    {
+			    return 0;
+		    }
+		    return std::max((task.due - mNow) * mResolution - mRemainder, Ogre::Real(0));
+	    }
+
+	    void advance(Ogre::Real time)
+	    {
+		    mRemainder += time;
+		    if (mRemainder < mResolution)
+		    {
+			    return;
+		    }
+
+		    boost::uint64_t steps = (boost::uint64_t) (mRemainder / mResolution);
+		    mRemainder = std::max(mRemainder - steps * mResolution, Ogre::Real(0));
+
+		    mAdvancing = true;
+		    try
+		    {
+			    for (; steps > 0; --steps)
+			    {
+				    //Nothing to move or call, skip to the end.
+				    if (mNumTasks == 0)
+				    {
+					    mNow += steps;
+					    break;
+				    }
+				    _step();
+			    }
+		    }
+		    catch (...)
+		    {
+			    mAdvancing = false;
+			    throw;
+		    }
+		    mAdvancing = false;
+	    }
+
+	    bool isAdvancing() const { return mAdvancing; }
+	    unsigned int getNumTasks() const { return mNumTasks; }
+	    Ogre::Real getTime() const { return mNow * mResolution + mRemainder; }
+
+	    //Only while no tasks are pending.
+	    void setResolution(Ogre::Real resolution)
+	    {
+		    Ogre::Real time = getTime();
+		    mResolution = resolution;
+		    mNow = (boost::uint64_t) (time / resolution);
+		    mRemainder = std::max(time - mNow * resolution, Ogre::Real(0));
+	    }
+    };
+
+    const unsigned int TaskWheel::NONE;
+    const unsigned int TaskWheel::FIRING;
+
+/*
+ * =====================================================================================
+ * NGF::Profiler
+ * =====================================================================================
+ */
+
+    bool ProfileScope::msEnabled = false;
+    const unsigned int ProfileScope::NO_TYPE;
+
+    static const boost::chrono::steady_clock::time_point profileEpoch = boost::chrono::steady_clock::now();
+
+    //Seconds since startup, for the profiler and the tick budget.
+    static double steadyNow()
+    {
+	    return boost::chrono::duration<double>(boost::chrono::steady_clock::now() - profileEpoch).count();
+    }
+
+    //The stats of each type by type index, those of no type, and the calls kept for
+    //traces. Only locked in the parallel part of the tick, when tick threads record too.
+    struct Profiler
+    {
+	    struct Event
+	    {
+		    unsigned int typeIndex;
+		    ProfileCategory category;
+		    const char *label;
+		    double start;
+		    double duration;
+		    unsigned int calls;
+		    unsigned int thread;
+	    };
+
+	    boost::mutex mutex;
+
+	    std::vector<ProfileStats> stats;
+	    ProfileStats untyped;
+
+	    bool tracing;
+	    unsigned int maxEvents;
+	    unsigned int numDropped;
+	    std::vector<Event> events;
+
+	    //Labels copied for ProfileScope, std::set doesn't move them.
+	    std::set<Ogre::String> labels;
+
+	    Profiler() : tracing(false), maxEvents(0), numDropped(0) { }
+
+	    ProfileStats &getStats(unsigned int typeIndex)
+	    {
+		    if (typeIndex == ProfileScope::NO_TYPE)
+		    {
+			    return untyped;
+		    }
+		    if (typeIndex >= stats.size())
+		    {
+			    stats.resize(typeIndex + 1);
+		    }
+		    return stats[typeIndex];
+	    }
+
+	    void record(unsigned int typeIndex, ProfileCategory category, const char *label, 
+			    double start, double end, unsigned int calls, unsigned int thread)
+	    {
+		    ProfileStats &typeStats = getStats(typeIndex);
+		    typeStats.calls[category] += calls;
+		    typeStats.time[category] += end - start;
+
+		    if (!tracing)
+		    {
+			    return;
+		    }
+		    if (events.size() >= maxEvents)
+		    {
+			    ++numDropped;
+			    return;
+		    }
+
+		    Event event = { typeIndex, category, label, start, end - start, calls, thread };
+		    events.push_back(event);
+	    }
+    };
+
+    static bool profileStatsEmpty(const ProfileStats &stats)
+    {
+	    for (unsigned int i = 0; i < NUM_PROFILE_CATEGORIES; ++i)
+	    {
+		    if (stats.calls[i])
+		    {
+			    return false;
+		    }
+	    }
+	    return stats.allocations == 0;
+    }
+
+    static void writeJSONString(std::ostream &out, const char *str)
+    {
+	    out << '"';
+	    for (; *str; ++str)
+	    {
+		    if (*str == '"' || *str == '\\')
+		    {
+			    out << '\\' << *str;
+		    }
+		    else if ((unsigned char) *str < 0x20)
+		    {
+			    out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int) *str 
+				    << std::dec << std::setfill(' ');
+		    }
+		    else
+		    {
+			    out << *str;
+		    }
+	    }
+	    out << '"';
+    }
+    //----------------------------------------------------------------------------------
+    double ProfileScope::_now()
+    {
+	    return steadyNow();
+    }
+    //----------------------------------------------------------------------------------
+    void ProfileScope::_end()
+    {
+	    _record(mTypeIndex, mCategory, mLabel, mStart, _now(), calls);
+    }
+    //----------------------------------------------------------------------------------
+    void ProfileScope::_record(unsigned int typeIndex, ProfileCategory category, const char *label, 
+		    double start, double end, unsigned int calls, unsigned int thread)
+    {
+	    GameObjectManager *mgr = GameObjectManager::getSingletonPtr();
+	    if (!mgr || !mgr->mProfiler)
+	    {
+		    return;
+	    }
+
+	    Profiler *profiler = mgr->mProfiler;
+	    if (mgr->mParallelPhase)
+	    {
+		    boost::mutex::scoped_lock lock(profiler->mutex);
+		    profiler->record(typeIndex, category, label, start, end, calls, thread);
+	    }
+	    else
+	    {
+		    profiler->record(typeIndex, category, label, start, end, calls, thread);
+	    }
+    }
+    //----------------------------------------------------------------------------------
+    void ProfileScope::_allocation(unsigned int typeIndex, size_t size, bool pooled)
+    {
+	    GameObjectManager *mgr = GameObjectManager::getSingletonPtr();
+	    if (!msEnabled || !mgr || !mgr->mProfiler)
+	    {
+		    return;
+	    }
+
+	    ProfileStats &stats = mgr->mProfiler->getStats(typeIndex);
+	    ++stats.allocations;
+	    stats.pooledAllocations += pooled;
+	    stats.allocatedBytes += size;
+    }
+    //----------------------------------------------------------------------------------
+    const char *ProfileScope::_intern(const Ogre::String &label)
+    {
+	    GameObjectManager *mgr = GameObjectManager::getSingletonPtr();
+	    if (!mgr || !mgr->mProfiler)
+	    {
+		    return 0;
+	    }
+
+	    Profiler *profiler = mgr->mProfiler;
+	    boost::mutex::scoped_lock lock(profiler->mutex);
+	    return profiler->labels.insert(label).first->c_str();
+    }
+
+/*
+ * =====================================================================================
+ * NGF::ObjectPool
+ * =====================================================================================
+ */
+
+    //Fixed-size blocks carved out of slabs. Free blocks are kept in a list threaded 
+    //through the blocks themselves, so the most recently freed block is used first.
+    class ObjectPool
+    {
+    protected:
+	    //Blocks are padded so anything can be put in them.
+	    enum { ALIGNMENT = 16 };
+
+	    size_t mBlockSize;
+	    unsigned int mSlabSize;
+	    std::vector<char*> mSlabs;
+	    void *mFree;
+	    PoolStats mStats;
+
+    public:
+	    ObjectPool(size_t blockSize, unsigned int slabSize)
+		    : mBlockSize((std::max(blockSize, sizeof(void*)) + ALIGNMENT - 1) & ~size_t(ALIGNMENT - 1)),
+		      mSlabSize(slabSize ? slabSize : 1),
+		      mFree(0)
+	    {
+	    }
+
+	    ~ObjectPool()
+	    {
+		    for (unsigned int i = 0; i < mSlabs.size(); ++i)
+		    {
+			    ::operator delete(mSlabs[i]);
+		    }
+	    }
+
+	    size_t getBlockSize() const { return mBlockSize; }
+	    const PoolStats &getStats() const { return mStats; }
+
+	    void *allocate()
+	    {
+		    if (!mFree)
+		    {
+			    //New slab, its blocks go in the free list in order.
+			    char *slab = (char *) ::operator new(mBlockSize * mSlabSize);
+			    mSlabs.push_back(slab);
+
+			    for (unsigned int i = mSlabSize; i-- > 0; )
+			    {
+				    void *block = slab + i * mBlockSize;
+				    *(void **) block = mFree;
+				    mFree = block;
+			    }
+
+			    ++mStats.numSlabs;
+			    mStats.capacity += mSlabSize;
+		    }
+
+		    void *block = mFree;
+		    mFree = *(void **) block;
+
+		    ++mStats.numUsed;
+		    mStats.peakUsed = std::max(mStats.peakUsed, mStats.numUsed);
+		    return block;
+	    }
+
+	    void deallocate(void *block)
+	    {
+		    *(void **) block = mFree;
+		    mFree = block;
+		    --mStats.numUsed;
+	    }
+    };
+
+/*
+ * =====================================================================================
+ * NGF::SpatialIndex
+ * =====================================================================================
+ */
+
+    //Transforms kept as structure-of-arrays, and a hash of grid cells to the transforms
+    //in them. Each transform knows its cell and where it is in the cell's list, so moving
+    //between cells and removing are O(1).
+    class SpatialIndex
+    {
+    protected:
+	    typedef boost::uint64_t CellKey;
+	    typedef boost::unordered_map<CellKey, std::vector<unsigned int> > CellMap;
+
+	    Ogre::Real mCellSize;
+
+	    std::vector<Ogre::Real> mX, mY, mZ;
+	    std::vector<Ogre::Quaternion> mRot;
+	    std::vector<GameObject*> mObjects;
+	    std::vector<CellKey> mCellKeys;
+	    std::vector<unsigned int> mCellSlots;
+
+	    CellMap mCells;
+
+	    //Cell coordinates are kept in 21 bits each. Positions past the last cell go in it.
+	    enum { CELL_BITS = 21, CELL_LIMIT = (1 << (CELL_BITS - 1)) - 1 };
+
+	    int _cellCoord(Ogre::Real x) const
+	    {
+		    const Ogre::Real limit = CELL_LIMIT;
+		    Ogre::Real c = std::floor(x / mCellSize);
+		    return (int) std::max(-limit, std::min(limit, c));
+	    }
+
+	    static CellKey _key(int x, int y, int z)
+	    {
+		    const CellKey mask = (CellKey(1) << CELL_BITS) - 1;
+		    return ((CellKey(x) & mask) << (2 * CELL_BITS)) | ((CellKey(y) & mask) << CELL_BITS) | (CellKey(z) & mask);
+	    }
+
+	    CellKey _keyOf(const Ogre::Vector3 &pos) const
+	    {
+		    return _key(_cellCoord(pos.x), _cellCoord(pos.y), _cellCoord(pos.z));
+	    }
+
+	    void _addToCell(unsigned int index, CellKey key)
+	    {
+		    std::vector<unsigned int> &cell = mCells[key];
+		    mCellKeys[index] = key;
+		    mCellSlots[index] = cell.size();
+		    cell.push_back(index);
+	    }
+
+	    void _removeFromCell(unsigned int index)
+	    {
+		    CellMap::iterator iter = mCells.find(mCellKeys[index]);
+		    std::vector<unsigned int> &cell = iter->second;
+		    unsigned int slot = mCellSlots[index];
+
+		    cell[slot] = cell.back();
+		    mCellSlots[cell[slot]] = slot;
+		    cell.pop_back();
+
+		    if (cell.empty())
+		    {
+			    mCells.erase(iter);
+		    }
+	    }
+
+	    Ogre::Real _squaredDistance(unsigned int index, const Ogre::Vector3 &pos) const
+	    {
+		    Ogre::Real dx = mX[index] - pos.x, dy = mY[index] - pos.y, dz = mZ[index] - pos.z;
+		    return dx * dx + dy * dy + dz * dz;
+	    }
+
+	    bool _inBox(unsigned int index, const Ogre::Vector3 &min, const Ogre::Vector3 &max) const
+	    {
+		    return mX[index] >= min.x && mX[index] <= max.x 
+			    && mY[index] >= min.y && mY[index] <= max.y 
+			    && mZ[index] >= min.z && mZ[index] <= max.z;
+	    }
+
+	    //Calls 'func(index)' for every transform in the cells touching the box. If there
+	    //are more cells in the box than there are in use, goes over the used ones instead.
+	    template<typename F>
+	    void _forEachNear(const Ogre::Vector3 &min, const Ogre::Vector3 &max, F &func) const
+	    {
+		    int x0 = _cellCoord(min.x), y0 = _cellCoord(min.y), z0 = _cellCoord(min.z);
+		    int x1 = _cellCoord(max.x), y1 = _cellCoord(max.y), z1 = _cellCoord(max.z);
+		    double numCells = double(x1 - x0 + 1) * double(y1 - y0 + 1) * double(z1 - z0 + 1);
+
+		    if (numCells > mCells.size())
+		    {
+			    for (CellMap::const_iterator iter = mCells.begin(); iter != mCells.end(); ++iter)
+			    {
+				    for (unsigned int i = 0; i < iter->second.size(); ++i)
+				    {
+					    func(iter->second[i]);
+				    }
+			    }
+			    return;
+		    }
+
+		    for (int x = x0; x <= x1; ++x)
+		    {
+			    for (int y = y0; y <= y1; ++y)
+			    {
+				    for (int z = z0; z <= z1; ++z)
+				    {
+					    CellMap::const_iterator iter = mCells.find(_key(x, y, z));
+					    if (iter == mCells.end())
+					    {
+						    continue;
+					    }
+
+					    for (unsigned int i = 0; i < iter->second.size(); ++i)
+					    {
+						    func(iter->second[i]);
+					    }
+				    }
+			    }
+		    }
+	    }
+
+	    void _gatherCell(CellKey key, const Ogre::Vector3 &center, std::vector<std::pair<Ogre::Real, unsigned int> > &found) const
+	    {
+		    CellMap::const_iterator iter = mCells.find(key);
+		    if (iter == mCells.end())
+		    {
+			    return;
+		    }
+
+		    for (unsigned int i = 0; i < iter->second.size(); ++i)
+		    {
+			    unsigned int index = iter->second[i];
+			    found.push_back(std::make_pair(_squaredDistance(index, center), index));
+		    }
+	    }
+
+	    //How close anything outside the ring of radius 'r' around cell (cx, cy, cz) could
+	    //be to 'center'. Measured from 'center' itself rather than its cell so it stays
+	    //right for positions past the grid's edge (which were put in the edge cell).
+	    Ogre::Real _ringReach(const Ogre::Vector3 &center, int cx, int cy, int cz, int r) const
+	    {
+		    Ogre::Real reach = std::numeric_limits<Ogre::Real>::infinity();
+		    const Ogre::Real pos[3] = { center.x, center.y, center.z };
+		    const int cell[3] = { cx, cy, cz };
+
+		    for (int i = 0; i < 3; ++i)
+		    {
+			    //A side only counts if there are cells past it.
+			    if (cell[i] - r > -CELL_LIMIT)
+			    {
+				    reach = std::min(reach, pos[i] - (cell[i] - r) * mCellSize);
+			    }
+			    if (cell[i] + r < CELL_LIMIT)
+			    {
+				    reach = std::min(reach, (cell[i] + r + 1) * mCellSize - pos[i]);
+			    }
+		    }
+
+		    return std::max(reach, Ogre::Real(0));
+	    }
+
+	    struct RadiusQuery
+	    {
+		    const SpatialIndex *index;
+		    Ogre::Vector3 center;
+		    Ogre::Real radius2;
+		    std::vector<ID> *result;
+		    unsigned int found;
+
+		    void operator()(unsigned int i)
+		    {
+			    if (index->_squaredDistance(i, center) <= radius2)
+			    {
+				    result->push_back(index->mObjects[i]->getID());
+				    ++found;
+			    }
+		    }
+	    };
+	    friend struct RadiusQuery;
+
+	    struct BoxQuery
+	    {
+		    const SpatialIndex *index;
+		    Ogre::Vector3 min, max;
+		    std::vector<ID> *result;
+		    unsigned int found;
+
+		    void operator()(unsigned int i)
+		    {
+			    if (index->_inBox(i, min, max))
+			    {
+				    result->push_back(index->mObjects[i]->getID());
+				    ++found;
+			    }
+		    }
+	    };
+	    friend struct BoxQuery;
+
+    public:
+	    SpatialIndex(Ogre::Real cellSize)
+		    : mCellSize(cellSize)
+	    {
+	    }
+
+	    unsigned int getNumTransforms() const { return mObjects.size(); }
+
+	    Ogre::Vector3 getPosition(unsigned int index) const { return Ogre::Vector3(mX[index], mY[index], mZ[index]); }
+	    const Ogre::Quaternion &getOrientation(unsigned int index) const { return mRot[index]; }
+	    void setOrientation(unsigned int index, const Ogre::Quaternion &rot) { mRot[index] = rot; }
+
+	    void add(GameObject *obj, const Ogre::Vector3 &pos, const Ogre::Quaternion &rot)
+	    {
+		    unsigned int index = mObjects.size();
+		    obj->mTransformIndex = index;
+
+		    mX.push_back(pos.x);
+		    mY.push_back(pos.y);
+		    mZ.push_back(pos.z);
+		    mRot.push_back(rot);
+		    mObjects.push_back(obj);
+		    mCellKeys.push_back(0);
+		    mCellSlots.push_back(0);
+
+		    _addToCell(index, _keyOf(pos));
+	    }
+
+	    void setPosition(unsigned int index, const Ogre::Vector3 &pos)
+	    {
+		    mX[index] = pos.x;
+		    mY[index] = pos.y;
+		    mZ[index] = pos.z;
+
+		    CellKey key = _keyOf(pos);
+		    if (key != mCellKeys[index])
+		    {
+			    _removeFromCell(index);
+			    _addToCell(index, key);
+		    }
+	    }
+
+	    void remove(GameObject *obj)
+	    {
+		    unsigned int index = obj->mTransformIndex;
+		    unsigned int last = mObjects.size() - 1;
+		    obj->mTransformIndex = ~0u;
+
+		    _removeFromCell(index);
+
+		    //Move the last one into the hole, and tell its cell.
+		    if (index != last)
+		    {
+			    mX[index] = mX[last];
+			    mY[index] = mY[last];
+			    mZ[index] = mZ[last];
+			    mRot[index] = mRot[last];
+			    mObjects[index] = mObjects[last];
+			    mCellKeys[index] = mCellKeys[last];
+			    mCellSlots[index] = mCellSlots[last];
+
+			    mObjects[index]->mTransformIndex = index;
+			    mCells[mCellKeys[index]][mCellSlots[index]] = index;
+		    }
+
+		    mX.pop_back();
+		    mY.pop_back();
+		    mZ.pop_back();
+		    mRot.pop_back();
+		    mObjects.pop_back();
+		    mCellKeys.pop_back();
+		    mCellSlots.pop_back();
+	    }
+
+	    void setCellSize(Ogre::Real size)
+	    {
+		    mCellSize = size;
+		    mCells.clear();
+
+		    for (unsigned int i = 0; i < mObjects.size(); ++i)
+		    {
+			    _addToCell(i, _keyOf(getPosition(i)));
+		    }
+	    }
+
+	    unsigned int queryRadius(const Ogre::Vector3 &center, Ogre::Real radius, std::vector<ID> &result) const
+	    {
+		    RadiusQuery query = { this, center, radius * radius, &result, 0 };
+		    Ogre::Vector3 extent(radius, radius, radius);
+		    _forEachNear(center - extent, center + extent, query);
+		    return query.found;
+	    }
+
+	    unsigned int queryBox(const Ogre::Vector3 &min, const Ogre::Vector3 &max, std::vector<ID> &result) const
+	    {
+		    BoxQuery query = { this, min, max, &result, 0 };
+		    _forEachNear(min, max, query);
+		    return query.found;
+	    }
+
+	    unsigned int queryNearest(const Ogre::Vector3 &center, unsigned int k, std::vector<ID> &result) const
+	    {
+		    k = std::min(k, (unsigned int) mObjects.size());
+		    if (!k)
+		    {
+			    return 0;
+		    }
+
+		    //Look through rings of cells around the center's cell, each step only visiting
+		    //the new shell. Once we have k and the k-th is no further than anything outside
+		    //the ring could be, we're done. If the rings get bigger than the number of cells
+		    //in use, just look at everything.
+		    std::vector<std::pair<Ogre::Real, unsigned int> > found;
+		    int cx = _cellCoord(center.x), cy = _cellCoord(center.y), cz = _cellCoord(center.z);
+
+		    for (int r = 0; ; ++r)
+		    {
+			    double ringCells = double(2 * r + 1) * double(2 * r + 1) * double(2 * r + 1);
+			    if (ringCells > 2.0 * mCells.size())
+			    {
+				    found.clear();
+				    for (unsigned int i = 0; i < mObjects.size(); ++i)
+				    {
+					    found.push_back(std::make_pair(_squaredDistance(i, center), i));
+				    }
+				    break;
+			    }
+
+			    //Cells past the edge of the grid don't exist, don't wrap around to the other side.
+			    int x0 = std::max(cx - r, -CELL_LIMIT), x1 = std::min(cx + r, (int) CELL_LIMIT);
+			    int y0 = std::max(cy - r, -CELL_LIMIT), y1 = std::min(cy + r, (int) CELL_LIMIT);
+
+			    for (int x = x0; x <= x1; ++x)
+			    {
+				    bool xFace = x == cx - r || x == cx + r;
+				    for (int y = y0; y <= y1; ++y)
+				    {
+					    //On an x or y face the whole z column is in the shell, otherwise only its ends.
+					    if (xFace || y == cy - r || y == cy + r)
+					    {
+						    int z0 = std::max(cz - r, -CELL_LIMIT), z1 = std::min(cz + r, (int) CELL_LIMIT);
+						    for (int z = z0; z <= z1; ++z)
+						    {
+							    _gatherCell(_key(x, y, z), center, found);
+						    }
+					    }
+					    else
+					    {
+						    if (cz - r >= -CELL_LIMIT)
+						    {
+							    _gatherCell(_key(x, y, cz - r), center, found);
+						    }
+						    if (cz + r <= CELL_LIMIT)
+						    {
+							    _gatherCell(_key(x, y, cz + r), center, found);
+						    }
+					    }
+				    }
+			    }
+
+			    if (found.size() >= k)
+			    {
+				    std::nth_element(found.begin(), found.begin() + (k - 1), found.end());
+				    Ogre::Real reach = _ringReach(center, cx, cy, cz, r);
+				    if (found[k - 1].first <= reach * reach)
+				    {
+					    break;
+				    }
+			    }
+		    }
+
+		    std::partial_sort(found.begin(), found.begin() + k, found.end());
+		    for (unsigned int i = 0; i < k; ++i)
+		    {
+			    result.push_back(mObjects[found[i].second]->getID());
+		    }
+
+		    return k;
+	    }
+    };
+
+/*
+ * =====================================================================================
+ * NGF::GameObjectManager
+ * =====================================================================================
+ */
+
+    const std::vector<GameObject*> GameObjectManager::msNoMembers;
+    //----------------------------------------------------------------------------------
+    GameObjectManager* GameObjectManager::getSingletonPtr(void)
+    {
+	    return msSingleton;
+    }
+    GameObjectManager& GameObjectManager::getSingleton(void)
+    {
+	    assert(msSingleton); return *msSingleton;
+    }
+    //----------------------------------------------------------------------------------
+    GameObjectManager::GameObjectManager()
+	    : mNumObjects(0),
+	      mObjectFactory(new GameObjectFactory()),
+	      mTicking(false),
+	      mWorkerPool(0),
+	      mParallelPhase(false),
+	      mScheduleDirty(true),
+	      mFixedTimeStep(0),
+	      mMaxSubSteps(5),
+	      mTimeAccumulator(0),
+	      mInterpolationAlpha(1),
+	      mSpatialIndex(0),
+	      mSpatialCellSize(10),
+	      mMessageQueueCapacity(0),
+	      mDeliveryLevel(-1),
+	      mCurrentRequest(~0u),
+	      mReplyQueue(new ReplyQueue()),
+	      mTaskWheel(0),
+	      mTaskResolution(0.01f),
+	      mDeferredClock(0),
+	      mTickBudget(0),
+	      mProfiler(0)
+    {
+	    addTickPhase("PrePhysics");
+	    addTickPhase("Physics", "PrePhysics");
+	    addTickPhase("Default", "Physics");
+	    addTickPhase("PostPhysics", "Physics");
+	    addTickPhase("Late", "Default PostPhysics");
+    }
+    //----------------------------------------------------------------------------------
+    GameObjectManager::~GameObjectManager()
+    {
+	    destroyAll(); 
+	    delete mObjectFactory;
+	    delete mSpatialIndex;
+	    delete mReplyQueue;
+	    delete mTaskWheel;
+	    ProfileScope::msEnabled = false;
+	    delete mProfiler;
+	    setTickThreads(0);
+
+	    std::vector<DeferredRing*>::iterator ring;
+	    for (ring = mDeferredRings.begin(); ring != mDeferredRings.end(); ++ring)
+	    {
+		    delete *ring;
+	    }
+
+	    std::vector<ObjectType*>::iterator iter;
+	    for (iter = mTypes.begin(); iter != mTypes.end(); ++iter)
+	    {
+		    //Persistent GameObjects may still live in the pool, leave it to them.
+		    ObjectPool *pool = (*iter)->pool;
+		    if (pool && pool->getStats().numUsed == 0)
+		    {
+			    delete pool;
+		    }
+
+		    delete *iter;
+	    }
+
+	    std::vector<Channel*>::iterator channel;
+	    for (channel = mChannels.begin(); channel != mChannels.end(); ++channel)
+	    {
+		    delete *channel;
+	    }
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::tick(bool paused, const Ogre::FrameEvent & evt)
+    {
+	    NGF_PROFILE(ProfileScope::NO_TYPE, PROFILE_TICK);
+
+	    if (mScheduleDirty)
+	    {
+		    _buildSchedule();
+	    }
+
+	    //Tasks see the time the unpaused ticks did.
+	    Ogre::Real unpausedTime = 0;
+
+	    //Types created during the loop are scheduled next frame. The scope's end leaves
+	    //the loop, even if a tick throws.
+	    {
+		    TickingScope ticking(this);
+
+		    if (paused)
+		    {
+			    _tickStep(TICKLIST_PAUSED, evt);
+		    }
+		    else if (mFixedTimeStep <= 0)
+		    {
+			    _tickStep(TICKLIST_UNPAUSED, evt);
+			    unpausedTime = evt.timeSinceLastFrame;
+			    _tickDeferred(unpausedTime);
+			    mInterpolationAlpha = 1;
+			    _tickStep(TICKLIST_INTERPOLATE, evt);
+		    }
+		    else
+		    {
+			    mTimeAccumulator += evt.timeSinceLastFrame;
+
+			    unsigned int numSteps = (unsigned int) (mTimeAccumulator / mFixedTimeStep);
+			    if (numSteps > mMaxSubSteps)
+			    {
+				    //Can't keep up, let go of the time we won't get to.
+				    numSteps = mMaxSubSteps;
+				    mTimeAccumulator = numSteps * mFixedTimeStep;
+			    }
+
+			    Ogre::FrameEvent stepEvt;
+			    stepEvt.timeSinceLastFrame = mFixedTimeStep;
+			    stepEvt.timeSinceLastEvent = mFixedTimeStep;
+
+			    for (unsigned int step = 0; step < numSteps; ++step)
+			    {
+				    _tickStep(TICKLIST_UNPAUSED, stepEvt);
+				    mTimeAccumulator -= mFixedTimeStep;
+			    }
+			    unpausedTime = numSteps * mFixedTimeStep;
+
+			    //Deferrable ticks are done once a frame, with all the steps' time.
+			    if (numSteps)
+			    {
+				    _tickDeferred(unpausedTime);
+			    }
+
+			    mTimeAccumulator = std::max(mTimeAccumulator, Ogre::Real(0));
+			    mInterpolationAlpha = std::min(mTimeAccumulator / mFixedTimeStep, Ogre::Real(1));
+			    _tickStep(TICKLIST_INTERPOLATE, evt);
+		    }
+	    }
+
+	    if (mTaskWheel && unpausedTime > 0)
+	    {
+		    advanceTasks(unpausedTime);
+	    }
+
+	    deliverMessages();
+
+	    std::vector<ID>::iterator iter;
+
+	    for (iter = mObjectsToDestroy.begin();
+			    iter != mObjectsToDestroy.end(); ++iter)
+	    {
+		    destroyObject(*iter);
+	    }
+	    mObjectsToDestroy.clear();
+
+	    mLastQueueStats = mQueueStats;
+	    mQueueStats = MessageQueueStats();
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::_tickStep(unsigned int list, const Ogre::FrameEvent &evt)
+    {
+	    bool parallel = list == TICKLIST_UNPAUSED && mWorkerPool;
+
+	    for (unsigned int level = 0; level < mPhaseLevels.size(); ++level)
+	    {
+		    const std::vector<unsigned int> &phases = mPhaseLevels[level];
+
+		    for (unsigned int i = 0; i < phases.size(); ++i)
+		    {
+			    const std::vector<ObjectType*> &types = mPhases[phases[i]].types;
+
+			    for (unsigned int j = 0; j < types.size(); ++j)
+			    {
+				    //Parallel types are done after the others in the level.
+				    if (parallel && types[j]->options.parallelTick)
+				    {
+					    continue;
+				    }
+
+				    _tickType(types[j], list, evt);
+			    }
+		    }
+
+		    if (parallel)
+		    {
+			    _parallelTick(level, evt);
+		    }
+
+		    if ((int) level == mDeliveryLevel)
+		    {
+			    deliverMessages();
+		    }
+	    }
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::_tickDeferred(Ogre::Real time)
+    {
+	    mDeferredClock += time;
+
+	    //Only the deferrable ticks count against the budget.
+	    double start = mTickBudget > 0 ? steadyNow() : 0;
+
+	    TickBudgetStats stats;
+	    stats.numFrames = 1;
+
+	    //Rings added during the loop wait for next frame, like the GameObjects in them.
+	    mDeferredPass = mDeferredOrder;
+	    bool overBudget = false;
+
+	    for (unsigned int r = 0; r < mDeferredPass.size(); ++r)
+	    {
+		    DeferredRing *ring = mDeferredRings[mDeferredPass[r]];
+		    unsigned int numObjs = ring->objs.size();
+
+		    //Go round once, starting where we stopped last frame.
+		    unsigned int stoppedAt = ~0u;
+		    bool ringTicked = false;
+		    for (unsigned int n = 0; n < numObjs; ++n)
+		    {
+			    unsigned int i = (ring->next + n) % numObjs;
+			    GameObject *obj = ring->objs[i];
+
+			    if (!obj)
+			    {
+				    continue;
+			    }
+
+			    //Always do at least one of each ring so lower priorities aren't starved.
+			    if (ringTicked && !overBudget && mTickBudget > 0 && steadyNow() - start > mTickBudget)
+			    {
+				    overBudget = true;
+			    }
+
+			    if (overBudget && ringTicked)
+			    {
+				    if (stoppedAt == ~0u)
+				    {
+					    stoppedAt = i;
+				    }
+				    ++stats.numDeferred;
+				    continue;
+			    }
+
+			    Ogre::FrameEvent evt;
+			    evt.timeSinceLastFrame = (Ogre::Real) (mDeferredClock - ring->lastTicks[i]);
+			    evt.timeSinceLastEvent = evt.timeSinceLastFrame;
+			    ring->lastTicks[i] = mDeferredClock;
+			    stats.longestWait = std::max(stats.longestWait, evt.timeSinceLastFrame);
+
+			    {
+				    NGF_PROFILE(obj, PROFILE_TICK);
+				    obj->unpausedTick(evt);
+			    }
+			    ++stats.numTicked;
+			    ringTicked = true;
+		    }
+
+		    if (stoppedAt != ~0u)
+		    {
+			    ring->next = stoppedAt;
+		    }
+	    }
+
+	    stats.numFramesDeferred = stats.numDeferred ? 1 : 0;
+	    mBudgetStats = stats;
+
+	    mBudgetTotals.numFrames += stats.numFrames;
+	    mBudgetTotals.numFramesDeferred += stats.numFramesDeferred;
+	    mBudgetTotals.numTicked += stats.numTicked;
+	    mBudgetTotals.numDeferred += stats.numDeferred;
+	    mBudgetTotals.longestWait = std::max(mBudgetTotals.longestWait, stats.longestWait);
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::_tickType(ObjectType *type, unsigned int list, const Ogre::FrameEvent &evt)
+    {
+	    //GameObjects created during the loop are appended, so we only go up to the size at
+	    //the start and index instead of using iterators. They get ticked next frame.
+	    //GameObjects that leave during the loop are NULLed out.
+	    std::vector<TickGroup*> &groups = type->tickLists[list].groups;
+	    unsigned int numGroups = groups.size();
+
+	    NGF_PROFILE(type->index, PROFILE_TICK);
+	    unsigned int numTicked = 0;
+
+	    for (unsigned int g = 0; g < numGroups; ++g)
+	    {
+		    Ogre::FrameEvent groupEvt;
+		    std::vector<GameObject*> &objs = _advanceTickGroup(groups[g], evt, groupEvt);
+		    unsigned int numObjs = objs.size();
+
+		    for (unsigned int i = 0; i < numObjs; ++i)
+		    {
+			    GameObject *obj = objs[i];
+
+			    if (!obj)
+			    {
+				    continue;
+			    }
+
+			    switch (list)
+			    {
+			    case TICKLIST_UNPAUSED:
+				    obj->unpausedTick(groupEvt);
+				    break;
+			    case TICKLIST_PAUSED:
+				    obj->pausedTick(groupEvt);
+				    break;
+			    case TICKLIST_INTERPOLATE:
+				    obj->interpolatedTick(groupEvt, mInterpolationAlpha);
+				    break;
+			    }
+			    ++numTicked;
+		    }
+	    }
+
+	    NGF_PROFILE_CALLS(numTicked);
+    }
+    //----------------------------------------------------------------------------------
+    std::vector<GameObject*> &GameObjectManager::_advanceTickGroup(TickGroup *group, 
+		    const Ogre::FrameEvent &evt, Ogre::FrameEvent &groupEvt)
+    {
+	    for (unsigned int b = 0; b < group->interval; ++b)
+	    {
+		    group->elapsed[b] += evt.timeSinceLastFrame;
+	    }
+
+	    //With an interval of 1 this is just 'evt'.
+	    unsigned int bucket = group->current;
+	    Ogre::Real extra = group->elapsed[bucket] - evt.timeSinceLastFrame;
+	    groupEvt.timeSinceLastFrame = group->elapsed[bucket];
+	    groupEvt.timeSinceLastEvent = evt.timeSinceLastEvent + extra;
+
+	    group->elapsed[bucket] = 0;
+	    group->current = (bucket + 1) % group->interval;
+
+	    return group->buckets[bucket];
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::addTickPhase(const Ogre::String &name, const Ogre::String &after)
+    {
+	    if (hasTickPhase(name))
+	    {
+		    OGRE_EXCEPT(Ogre::Exception::ERR_DUPLICATE_ITEM, "Tick phase '" + name + "' already exists!", 
+				    "NGF::GameObjectManager::addTickPhase()");
+	    }
+
+	    TickPhase phase;
+	    phase.name = name;
+	    phase.level = -1;
+
+	    Ogre::StringVector names = Ogre::StringUtil::split(after, " ");
+	    for (Ogre::StringVector::iterator iter = names.begin(); iter != names.end(); ++iter)
+	    {
+		    if (!iter->empty())
+		    {
+			    phase.after.push_back(*iter);
+		    }
+	    }
+
+	    mPhases.push_back(phase);
+	    mScheduleDirty = true;
+    }
+    //----------------------------------------------------------------------------------
+    bool GameObjectManager::hasTickPhase(const Ogre::String &name) const
+    {
+	    for (unsigned int i = 0; i < mPhases.size(); ++i)
+	    {
+		    if (mPhases[i].name == name)
+		    {
+			    return true;
+		    }
+	    }
+
+	    return false;
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::_buildSchedule()
+    {
+	    unsigned int numPhases = mPhases.size();
+
+	    //Find the phase indices by name.
+	    std::map<Ogre::String, unsigned int> indices;
+	    for (unsigned int i = 0; i < numPhases; ++i)
+	    {
+		    indices[mPhases[i].name] = i;
+		    mPhases[i].level = -1;
+		    mPhases[i].types.clear();
+	    }
+
+	    //A phase's level is one more than the highest level it comes after. Each pass
+	    //places at least one phase unless there's a cycle.
+	    unsigned int numPlaced = 0;
+	    int numLevels = 0;
+	    for (unsigned int pass = 0; pass < numPhases && numPlaced < numPhases; ++pass)
+	    {
+		    for (unsigned int i = 0; i < numPhases; ++i)
+		    {
+			    TickPhase &phase = mPhases[i];
+			    if (phase.level >= 0)
+			    {
+				    continue;
+			    }
+
+			    int level = 0;
+			    std::vector<Ogre::String>::iterator dep;
+			    for (dep = phase.after.begin(); dep != phase.after.end(); ++dep)
+			    {
+				    std::map<Ogre::String, unsigned int>::iterator found = indices.find(*dep);
+				    if (found == indices.end())
+				    {
+					    OGRE_EXCEPT(Ogre::Exception::ERR_ITEM_NOT_FOUND, "Tick phase '" + phase.name 
+							    + "' comes after unknown phase '" + *dep + "'!", 
+							    "NGF::GameObjectManager::tick()");
+				    }
+
+				    int depLevel = mPhases[found->second].level;
+				    if (depLevel < 0)
+				    {
+					    level = -1;
+					    break;
+				    }
+				    level = std::max(level, depLevel + 1);
+			    }
+
+			    if (level >= 0)
+			    {
+				    phase.level = level;
+				    numLevels = std::max(numLevels, level + 1);
+				    ++numPlaced;
+			    }
+		    }
+	    }
+
+	    if (numPlaced < numPhases)
+	    {
+		    OGRE_EXCEPT(Ogre::Exception::ERR_INVALIDPARAMS, "Tick phases depend on each other in a circle!", 
+				    "NGF::GameObjectManager::tick()");
+	    }
+
+	    mPhaseLevels.clear();
+	    mPhaseLevels.resize(numLevels);
+	    for (unsigned int i = 0; i < numPhases; ++i)
+	    {
+		    mPhaseLevels[mPhases[i].level].push_back(i);
+	    }
+
+	    //Put the types in their phases.
+	    std::vector<ObjectType*>::iterator iter;
+	    for (iter = mTypes.begin(); iter != mTypes.end(); ++iter)
+	    {
+		    const Ogre::String &phaseName = (*iter)->options.tickPhase;
+		    std::map<Ogre::String, unsigned int>::iterator found = indices.find(phaseName);
+
+		    if (found == indices.end())
+		    {
+			    OGRE_EXCEPT(Ogre::Exception::ERR_ITEM_NOT_FOUND, "Type '" + (*iter)->name 
+					    + "' ticks in unknown phase '" + phaseName + "'!", 
+					    "NGF::GameObjectManager::tick()");
+		    }
+
+		    mPhases[found->second].types.push_back(*iter);
+	    }
+
+	    mDeliveryLevel = -1;
+	    if (!mDeliveryPhase.empty())
+	    {
+		    std::map<Ogre::String, unsigned int>::iterator found = indices.find(mDeliveryPhase);
+
+		    if (found == indices.end())
+		    {
+			    OGRE_EXCEPT(Ogre::Exception::ERR_ITEM_NOT_FOUND, "Unknown message delivery phase '" 
+					    + mDeliveryPhase + "'!", "NGF::GameObjectManager::tick()");
+		    }
+
+		    mDeliveryLevel = mPhases[found->second].level;
+	    }
+
+	    mScheduleDirty = false;
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::setTickThreads(unsigned int numThreads, unsigned int grain)
+    {
+	    delete mWorkerPool;
+	    mWorkerPool = 0;
+
+	    std::vector<CommandBuffer*>::iterator iter;
+	    for (iter = mCommandBuffers.begin(); iter != mCommandBuffers.end(); ++iter)
+	    {
+		    delete *iter;
+	    }
+	    mCommandBuffers.clear();
+
+	    if (numThreads > 1)
+	    {
+		    mWorkerPool = new WorkerPool(numThreads, grain);
+
+		    for (unsigned int i = 0; i < numThreads; ++i)
+		    {
+			    mCommandBuffers.push_back(new CommandBuffer());
+		    }
+	    }
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::setFixedTimeStep(Ogre::Real step, unsigned int maxSubSteps)
+    {
+	    //No steps would ever be run.
+	    if (step > 0 && maxSubSteps == 0)
+	    {
+		    OGRE_EXCEPT(Ogre::Exception::ERR_INVALIDPARAMS, "Need at least one sub-step per frame!", 
+				    "NGF::GameObjectManager::setFixedTimeStep()");
+	    }
+
+	    mFixedTimeStep = std::max(step, Ogre::Real(0));
+	    mMaxSubSteps = maxSubSteps;
+	    mTimeAccumulator = 0;
+	    mInterpolationAlpha = 1;
+    }
+    //----------------------------------------------------------------------------------
+    unsigned int GameObjectManager::getTickThreads() const
+    {
+	    return mWorkerPool ? mWorkerPool->getNumWorkers() : 1;
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::_parallelTick(unsigned int level, const Ogre::FrameEvent &evt)
+    {
+	    //Gather the GameObjects into one list, in the order a serial tick would go.
+	    mParallelItems.clear();
+
+	    const std::vector<unsigned int> &phases = mPhaseLevels[level];
+	    for (unsigned int p = 0; p < phases.size(); ++p)
+	    {
+		    const std::vector<ObjectType*> &types = mPhases[phases[p]].types;
+
+		    for (unsigned int t = 0; t < types.size(); ++t)
+		    {
+			    if (!types[t]->options.parallelTick)
+			    {
+				    continue;
+			    }
+
+			    std::vector<TickGroup*> &groups = types[t]->tickLists[TICKLIST_UNPAUSED].groups;
+			    for (unsigned int g = 0; g < groups.size(); ++g)
+			    {
+				    ParallelItem item;
+				    item.typeIndex = types[t]->index;
+				    std::vector<GameObject*> &objs = _advanceTickGroup(groups[g], evt, item.evt);
+
+				    for (unsigned int i = 0; i < objs.size(); ++i)
+				    {
+					    if (objs[i])
+					    {
+						    item.obj = objs[i];
+						    mParallelItems.push_back(item);
+					    }
+				    }
+			    }
+		    }
+	    }
+
+	    if (mParallelItems.empty())
+	    {
+		    return;
+	    }
+
+	    ParallelTickJob job(this);
+
+	    mParallelPhase = true;
+	    try
+	    {
+		    mWorkerPool->run(&job, mParallelItems.size());
+	    }
+	    catch (...)
+	    {
+		    mParallelPhase = false;
+		    _runCommandBuffers();
+		    throw;
+	    }
+	    mParallelPhase = false;
+
+	    _runCommandBuffers();
+    }
+    //----------------------------------------------------------------------------------
+    CommandBuffer *GameObjectManager::_getCommandBuffer() const
+    {
+	    return currCommandBuffer.get();
+    }
+    //----------------------------------------------------------------------------------
+    bool GameObjectManager::_deferCreate(CreateFunction func, const Ogre::Vector3 &pos, 
+		    const Ogre::Quaternion &rot, const PropertyList &properties, const Ogre::String &name)
+    {
+	    CommandBuffer *cmds = _getCommandBuffer();
+
+	    if (!cmds)
+	    {
+		    return false;
+	    }
+
+	    CommandBuffer::Command &cmd = cmds->add(CommandBuffer::Command::CREATE);
+	    cmd.create = func;
+	    cmd.pos = pos;
+	    cmd.rot = rot;
+	    cmd.properties = properties;
+	    cmd.name = name;
+
+	    return true;
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::_runCommandBuffers()
+    {
+	    //Each GameObject ticked on one thread, so its commands are together and in order 
+	    //in one buffer. A stable sort on the item puts everything in serial tick order.
+	    //The commands stay where they are, only where they are is sorted.
+	    mCommandOrder.clear();
+
+	    for (unsigned int b = 0; b < mCommandBuffers.size(); ++b)
+	    {
+		    CommandBuffer *cmds = mCommandBuffers[b];
+		    cmds->running.swap(cmds->commands);
+
+		    for (unsigned int i = 0; i < cmds->running.size(); ++i)
+		    {
+			    CommandRef ref = { cmds->running[i].item, b, i };
+			    mCommandOrder.push_back(ref);
+		    }
+	    }
+
+	    if (mCommandOrder.empty())
+	    {
+		    return;
+	    }
+
+	    std::stable_sort(mCommandOrder.begin(), mCommandOrder.end());
+
+	    try
+	    {
+		    std::vector<CommandRef>::iterator ref;
+		    for (ref = mCommandOrder.begin(); ref != mCommandOrder.end(); ++ref)
+		    {
+			    CommandBuffer::Command &cmd = mCommandBuffers[ref->buffer]->running[ref->index];
+
+			    switch (cmd.type)
+			    {
+				    case CommandBuffer::Command::CREATE:
+					    cmd.create(cmd.pos, cmd.rot, cmd.properties, cmd.name);
+					    break;
+
+				    case CommandBuffer::Command::DESTROY:
+					    destroyObject(cmd.id);
+					    break;
+
+				    case CommandBuffer::Command::REQUEST_DESTROY:
+					    requestDestroy(cmd.id);
+					    break;
+
+				    case CommandBuffer::Command::SEND_MESSAGE:
+					    sendMessage(getByID(cmd.id), cmd.msg);
+					    break;
+
+				    case CommandBuffer::Command::POST_MESSAGE:
+					    postMessageByID(cmd.id, cmd.msg);
+					    break;
+			    }
+		    }
+	    }
+	    catch (...)
+	    {
+		    for (unsigned int b = 0; b < mCommandBuffers.size(); ++b)
+		    {
+			    mCommandBuffers[b]->running.clear();
+		    }
+		    throw;
+	    }
+
+	    for (unsigned int b = 0; b < mCommandBuffers.size(); ++b)
+	    {
+		    mCommandBuffers[b]->running.clear();
+	    }
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::requestDestroy(ID objID)
+    {
+	    if (mParallelPhase)
+	    {
+		    if (CommandBuffer *cmds = _getCommandBuffer())
+		    {
+			    cmds->add(CommandBuffer::Command::REQUEST_DESTROY).id = objID;
+			    return;
+		    }
+	    }
+
+	    mObjectsToDestroy.push_back(objID);
+    }
+    //----------------------------------------------------------------------------------
+    ID GameObjectManager::_nextFreeID()
+    {
+	    //The free slot stack might still contain slots taken by '_createObject' with a
+	    //given ID, we skip those here.
+	    while (!mFreeSlots.empty())
+	    {
+		    unsigned int index = mFreeSlots.back();
+
+		    if (!mSlots[index].obj && !mSlots[index].reserved)
+		    {
+			    return makeID(index, mSlots[index].generation);
+		    }
+
+		    mFreeSlots.pop_back();
+	    }
+
+	    if (mSlots.size() >= (1u << NGF_ID_INDEX_BITS))
+	    {
+		    OGRE_EXCEPT(Ogre::Exception::ERR_INVALID_STATE, "Too many GameObjects!", 
+				    "NGF::GameObjectManager::createObject()");
+	    }
+
+	    return makeID(mSlots.size(), 0);
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::_reserveSlot(ID id)
+    {
+	    unsigned int index = getIDIndex(id);
+
+	    //If the slot is past the end, the ones in between become free.
+	    if (index >= mSlots.size())
+	    {
+		    for (unsigned int i = mSlots.size(); i < index; ++i)
+		    {
+			    mFreeSlots.push_back(i);
+		    }
+		    mSlots.resize(index + 1);
+	    }
+	    else if (!mFreeSlots.empty() && mFreeSlots.back() == index)
+	    {
+		    mFreeSlots.pop_back();
+	    }
+
+	    mSlots[index].reserved = true;
+	    mSlots[index].generation = getIDGeneration(id);
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::_releaseSlot(unsigned int index)
+    {
+	    //The ID might have been seen during construction, so it goes stale.
+	    mSlots[index].reserved = false;
+	    mSlots[index].generation = (mSlots[index].generation + 1) & ((1u << NGF_ID_GENERATION_BITS) - 1);
+	    mFreeSlots.push_back(index);
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::_insertObject(GameObject *obj, const Ogre::Vector3 &pos, const Ogre::Quaternion &rot)
+    {
+	    //'_createObject' reserved the slot.
+	    unsigned int index = getIDIndex(obj->getID());
+	    mSlots[index].obj = obj;
+	    mSlots[index].reserved = false;
+	    ++mNumObjects;
+
+	    if (!obj->mName.empty())
+	    {
+		    mNameMap[obj->mName] = obj;
+	    }
+
+	    //Subscribe to ticks.
+	    unsigned int flags = obj->mTickFlags;
+	    if (flags == TICK_DEFAULT)
+	    {
+		    flags = _getType(obj->mTypeIndex)->options.tickFlags;
+	    }
+
+	    obj->mTickFlags = TICK_NONE;
+	    obj->mManaged = true;
+	    _setTickFlags(obj, flags);
+
+	    _addToIndices(obj);
+
+	    if (_getType(obj->mTypeIndex)->options.hasTransform)
+	    {
+		    setTransform(obj, pos, rot);
+	    }
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::_removeObject(unsigned int index)
+    {
+	    GameObject *obj = mSlots[index].obj;
+
+	    if (!obj->mName.empty())
+	    {
+		    mNameMap.erase(obj->mName);
+	    }
+
+	    _setTickFlags(obj, TICK_NONE);
+	    _removeFromIndices(obj);
+	    if (hasTransform(obj))
+	    {
+		    removeTransform(obj);
+	    }
+	    _forgetObject(obj);
+	    obj->mManaged = false;
+
+	    //Bump the generation so IDs referring to the old GameObject become stale.
+	    mSlots[index].obj = 0;
+	    mSlots[index].generation = (mSlots[index].generation + 1) & ((1u << NGF_ID_GENERATION_BITS) - 1);
+	    mFreeSlots.push_back(index);
+	    --mNumObjects;
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::_addToIndices(GameObject *obj)
+    {
+	    std::vector<GameObject*> &members = _getType(obj->mTypeIndex)->members;
+	    obj->mTypeMemberIndex = members.size();
+	    members.push_back(obj);
+
+	    obj->mFlagIndices.clear();
+	    for (FlagID flag = 0; flag < NGF_MAX_FLAGS; ++flag)
+	    {
+		    if (obj->mFlags.test(flag))
+		    {
+			    _addToFlagIndex(obj, flag);
+		    }
+	    }
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::_removeFromIndices(GameObject *obj)
+    {
+	    std::vector<GameObject*> &members = _getType(obj->mTypeIndex)->members;
+	    unsigned int index = obj->mTypeMemberIndex;
+	    members[index] = members.back();
+	    members[index]->mTypeMemberIndex = index;
+	    members.pop_back();
+
+	    while (!obj->mFlagIndices.empty())
+	    {
+		    _removeFromFlagIndex(obj, obj->mFlagIndices.back().first);
+	    }
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::_addToFlagIndex(GameObject *obj, FlagID flag)
+    {
+	    if (flag >= mFlagMembers.size())
+	    {
+		    mFlagMembers.resize(flag + 1);
+	    }
+
+	    std::vector<GameObject*> &objs = mFlagMembers[flag];
+	    obj->mFlagIndices.push_back(std::make_pair(flag, (unsigned int) objs.size()));
+	    objs.push_back(obj);
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::_removeFromFlagIndex(GameObject *obj, FlagID flag)
+    {
+	    //A GameObject has few flags, so a search through its own is quick.
+	    std::vector<std::pair<FlagID, unsigned int> > &entries = obj->mFlagIndices;
+	    unsigned int k = 0;
+	    while (entries[k].first != flag)
+	    {
+		    ++k;
+	    }
+
+	    std::vector<GameObject*> &objs = mFlagMembers[flag];
+	    unsigned int index = entries[k].second;
+	    GameObject *moved = objs.back();
+	    objs[index] = moved;
+	    objs.pop_back();
+
+	    for (unsigned int m = 0; m < moved->mFlagIndices.size(); ++m)
+	    {
+		    if (moved->mFlagIndices[m].first == flag)
+		    {
+			    moved->mFlagIndices[m].second = index;
+		    }
+	    }
+
+	    entries[k] = entries.back();
+	    entries.pop_back();
+    }
+    //----------------------------------------------------------------------------------
+    GameObjectManager::ObjectRange GameObjectManager::getObjectsWithFlag(FlagID flag) const
+    {
+	    const std::vector<GameObject*> &objs = flag < mFlagMembers.size() ? mFlagMembers[flag] : msNoMembers;
+	    return ObjectRange(objs.begin(), objs.end());
+    }
+    //----------------------------------------------------------------------------------
+    GameObjectManager::ObjectRange GameObjectManager::getObjectsWithFlag(const Ogre::String &flag) const
+    {
+	    FlagID id;
+
+	    if (!FlagRegistry::findFlag(flag, id))
+	    {
+		    return ObjectRange(msNoMembers.begin(), msNoMembers.end());
+	    }
+
+	    return getObjectsWithFlag(id);
+    }
+    //----------------------------------------------------------------------------------
+    GameObjectManager::ObjectRange GameObjectManager::getObjectsOfType(const Ogre::String &type) const
+    {
+	    std::vector<ObjectType*>::const_iterator iter;
+	    for (iter = mTypes.begin(); iter != mTypes.end(); ++iter)
+	    {
+		    if ((*iter)->name == type)
+		    {
+			    return _getTypeMembers(*iter);
+		    }
+	    }
+
+	    return ObjectRange(msNoMembers.begin(), msNoMembers.end());
+    }
+    //----------------------------------------------------------------------------------
+    SpatialIndex *GameObjectManager::_getSpatialIndex()
+    {
+	    if (!mSpatialIndex)
+	    {
+		    mSpatialIndex = new SpatialIndex(mSpatialCellSize);
+	    }
+
+	    return mSpatialIndex;
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::setTransform(GameObject *obj, const Ogre::Vector3 &pos, const Ogre::Quaternion &rot)
+    {
+	    if (hasTransform(obj))
+	    {
+		    mSpatialIndex->setPosition(obj->mTransformIndex, pos);
+		    mSpatialIndex->setOrientation(obj->mTransformIndex, rot);
+	    }
+	    else
+	    {
+		    //Transforms go away with the slot, so a GameObject that isn't in one can't have one.
+		    if (!obj->mManaged)
+		    {
+			    OGRE_EXCEPT(Ogre::Exception::ERR_INVALID_STATE, "GameObject isn't created yet! Register its "
+					    "type with TypeOptions().transform() to give it a transform from the start.", 
+					    "NGF::GameObjectManager::setTransform()");
+		    }
+
+		    _getSpatialIndex()->add(obj, pos, rot);
+	    }
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::setPosition(GameObject *obj, const Ogre::Vector3 &pos)
+    {
+	    if (hasTransform(obj))
+	    {
+		    mSpatialIndex->setPosition(obj->mTransformIndex, pos);
+	    }
+	    else
+	    {
+		    //Transforms go away with the slot, so a GameObject that isn't in one can't have one.
+		    if (!obj->mManaged)
+		    {
+			    OGRE_EXCEPT(Ogre::Exception::ERR_INVALID_STATE, "GameObject isn't created yet! Register its "
+					    "type with TypeOptions().transform() to give it a transform from the start.", 
+					    "NGF::GameObjectManager::setPosition()");
+		    }
+
+		    _getSpatialIndex()->add(obj, pos, Ogre::Quaternion::IDENTITY);
+	    }
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::setOrientation(GameObject *obj, const Ogre::Quaternion &rot)
+    {
+	    if (!hasTransform(obj))
+	    {
+		    OGRE_EXCEPT(Ogre::Exception::ERR_ITEM_NOT_FOUND, "GameObject has no transform!", 
+				    "NGF::GameObjectManager::setOrientation()");
+	    }
+
+	    mSpatialIndex->setOrientation(obj->mTransformIndex, rot);
+    }
+    //----------------------------------------------------------------------------------
+    Ogre::Vector3 GameObjectManager::getPosition(const GameObject *obj) const
+    {
+	    if (!hasTransform(obj))
+	    {
+		    OGRE_EXCEPT(Ogre::Exception::ERR_ITEM_NOT_FOUND, "GameObject has no transform!", 
+				    "NGF::GameObjectManager::getPosition()");
+	    }
+
+	    return mSpatialIndex->getPosition(obj->mTransformIndex);
+    }
+    //----------------------------------------------------------------------------------
+    Ogre::Quaternion GameObjectManager::getOrientation(const GameObject *obj) const
+    {
+	    if (!hasTransform(obj))
+	    {
+		    OGRE_EXCEPT(Ogre::Exception::ERR_ITEM_NOT_FOUND, "GameObject has no transform!", 
+				    "NGF::GameObjectManager::getOrientation()");
+	    }
+
+	    return mSpatialIndex->getOrientation(obj->mTransformIndex);
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::removeTransform(GameObject *obj)
+    {
+	    if (hasTransform(obj))
+	    {
+		    mSpatialIndex->remove(obj);
+	    }
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::setSpatialCellSize(Ogre::Real size)
+    {
+	    if (size <= 0)
+	    {
+		    OGRE_EXCEPT(Ogre::Exception::ERR_INVALIDPARAMS, "Cell size must be positive!", 
+				    "NGF::GameObjectManager::setSpatialCellSize()");
+	    }
+
+	    mSpatialCellSize = size;
+	    if (mSpatialIndex)
+	    {
+		    mSpatialIndex->setCellSize(size);
+	    }
+    }
+    //----------------------------------------------------------------------------------
+    unsigned int GameObjectManager::queryRadius(const Ogre::Vector3 &center, Ogre::Real radius, 
+		    std::vector<ID> &result) const
+    {
+	    return mSpatialIndex ? mSpatialIndex->queryRadius(center, radius, result) : 0;
+    }
+    //----------------------------------------------------------------------------------
+    unsigned int GameObjectManager::queryBox(const Ogre::Vector3 &min, const Ogre::Vector3 &max, 
+		    std::vector<ID> &result) const
+    {
+	    return mSpatialIndex ? mSpatialIndex->queryBox(min, max, result) : 0;
+    }
+    //----------------------------------------------------------------------------------
+    unsigned int GameObjectManager::queryNearest(const Ogre::Vector3 &center, unsigned int k, 
+		    std::vector<ID> &result) const
+    {
+	    return mSpatialIndex ? mSpatialIndex->queryNearest(center, k, result) : 0;
+    }
+    //----------------------------------------------------------------------------------
+    void *GameObjectManager::_allocateObject(unsigned int typeIndex, size_t size)
+    {
+	    ObjectType *type = _getType(typeIndex);
+
+	    if (!type->options.poolSlabSize)
+	    {
+		    return 0;
+	    }
+
+	    if (!type->pool)
+	    {
+		    type->pool = new ObjectPool(size, type->options.poolSlabSize);
+	    }
+
+	    return type->pool->allocate();
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::_deallocateObject(unsigned int typeIndex, void *mem)
+    {
+	    _getType(typeIndex)->pool->deallocate(mem);
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::_freeObject(GameObject *obj)
+    {
+	    if (!obj->mPooled)
+	    {
+		    delete obj;
+		    return;
+	    }
+
+	    //The block starts at the most derived object, which isn't always the GameObject.
+	    unsigned int typeIndex = obj->mTypeIndex;
+	    void *mem = dynamic_cast<void *>(obj);
+
+	    obj->~GameObject();
+	    _deallocateObject(typeIndex, mem);
+    }
+    //----------------------------------------------------------------------------------
+    PoolStats GameObjectManager::_getPoolStats(unsigned int typeIndex)
+    {
+	    ObjectType *type = _getType(typeIndex);
+	    return type->pool ? type->pool->getStats() : PoolStats();
+    }
+    //----------------------------------------------------------------------------------
+    GameObjectManager::ObjectType *GameObjectManager::_getType(unsigned int typeIndex)
+    {
+	    while (typeIndex >= mTypes.size())
+	    {
+		    mTypes.push_back(new ObjectType(mTypes.size()));
+		    mScheduleDirty = true;
+	    }
+
+	    return mTypes[typeIndex];
+    }
+    //----------------------------------------------------------------------------------
+    unsigned int GameObjectManager::_newTypeIndex()
+    {
+	    static unsigned int numTypes = 0;
+	    return numTypes++;
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::_checkTypeOptions(const TypeOptions &options)
+    {
+	    //Deferrable ticks run on the main thread after the phases.
+	    if (options.deferrableTick && options.parallelTick)
+	    {
+		    OGRE_EXCEPT(Ogre::Exception::ERR_INVALIDPARAMS, "A type's ticks can't be both deferrable and parallel!", 
+				    "NGF::GameObjectManager::setTypeOptions()");
+	    }
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::_setTickFlags(GameObject *obj, unsigned int flags)
+    {
+	    static const unsigned int listFlags[NUM_TICKLISTS] = { TICK_UNPAUSED, TICK_PAUSED, TICK_INTERPOLATE };
+
+	    for (unsigned int list = 0; list < NUM_TICKLISTS; ++list)
+	    {
+		    bool had = (obj->mTickFlags & listFlags[list]) != 0;
+		    bool wants = (flags & listFlags[list]) != 0;
+
+		    if (wants && !had)
+		    {
+			    _addToTickList(obj, list);
+		    }
+		    else if (had && !wants)
+		    {
+			    _removeFromTickList(obj, list);
+		    }
+	    }
+
+	    obj->mTickFlags = flags;
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::_setTickInterval(GameObject *obj, unsigned int frames)
+    {
+	    //Leave the tick lists and join them again in the right group.
+	    unsigned int flags = obj->mTickFlags;
+	    _setTickFlags(obj, TICK_NONE);
+	    obj->mTickInterval = frames;
+	    _setTickFlags(obj, flags);
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::_setDeferrableTick(GameObject *obj, bool deferrable, int priority)
+    {
+	    //Like _setTickInterval.
+	    unsigned int flags = obj->mTickFlags;
+	    _setTickFlags(obj, TICK_NONE);
+	    obj->mTickDeferrable = deferrable;
+	    obj->mTickPriority = priority;
+	    _setTickFlags(obj, flags);
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::_forgetObject(GameObject *obj)
+    {
+	    if (!obj->mSubscriptions.empty())
+	    {
+		    _unsubscribeAll(obj);
+	    }
+	    if (obj->mFirstTask != ~0u)
+	    {
+		    mTaskWheel->cancelOwned(obj);
+	    }
+    }
+    //----------------------------------------------------------------------------------
+    bool GameObjectManager::_isTickDeferrable(const GameObject *obj)
+    {
+	    if (obj->mTickDeferrable < 0)
+	    {
+		    return _getType(obj->mTypeIndex)->options.deferrableTick;
+	    }
+	    return obj->mTickDeferrable > 0;
+    }
+    //----------------------------------------------------------------------------------
+    int GameObjectManager::_getTickPriority(const GameObject *obj)
+    {
+	    if (obj->mTickDeferrable < 0)
+	    {
+		    return _getType(obj->mTypeIndex)->options.tickPriority;
+	    }
+	    return obj->mTickPriority;
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::_addToDeferredRing(GameObject *obj)
+    {
+	    int priority = _getTickPriority(obj);
+
+	    //Find the ring for the priority, or make one in its place in the order.
+	    std::vector<unsigned int>::iterator iter = mDeferredOrder.begin();
+	    while (iter != mDeferredOrder.end() && mDeferredRings[*iter]->priority > priority)
+	    {
+		    ++iter;
+	    }
+	    if (iter == mDeferredOrder.end() || mDeferredRings[*iter]->priority != priority)
+	    {
+		    iter = mDeferredOrder.insert(iter, mDeferredRings.size());
+		    mDeferredRings.push_back(new DeferredRing(priority));
+	    }
+
+	    //Join at the end, the round gets to it like the rest.
+	    DeferredRing *ring = mDeferredRings[*iter];
+	    obj->mTickGroups[TICKLIST_UNPAUSED] = DEFERRED_GROUP;
+	    obj->mTickBuckets[TICKLIST_UNPAUSED] = *iter;
+	    obj->mTickIndices[TICKLIST_UNPAUSED] = ring->objs.size();
+	    ring->objs.push_back(obj);
+	    ring->lastTicks.push_back(mDeferredClock);
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::_removeFromDeferredRing(GameObject *obj)
+    {
+	    //Always NULLed out, moving the others would upset the round.
+	    DeferredRing *ring = mDeferredRings[obj->mTickBuckets[TICKLIST_UNPAUSED]];
+	    ring->objs[obj->mTickIndices[TICKLIST_UNPAUSED]] = 0;
+	    ring->dirty = true;
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::_compactDeferredRings(bool managedOnly)
+    {
+	    std::vector<DeferredRing*>::iterator iter;
+
+	    for (iter = mDeferredRings.begin(); iter != mDeferredRings.end(); ++iter)
+	    {
+		    DeferredRing *ring = *iter;
+
+		    if (!ring->dirty && !managedOnly)
+		    {
+			    continue;
+		    }
+
+		    //Remove the NULLs, keeping the order and the cursor's place in it.
+		    unsigned int j = 0;
+		    unsigned int next = 0;
+
+		    for (unsigned int i = 0; i < ring->objs.size(); ++i)
+		    {
+			    GameObject *obj = ring->objs[i];
+
+			    if (obj && (!managedOnly || obj->mManaged))
+			    {
+				    ring->objs[j] = obj;
+				    ring->lastTicks[j] = ring->lastTicks[i];
+				    obj->mTickIndices[TICKLIST_UNPAUSED] = j;
+				    ++j;
+			    }
+
+			    if (i + 1 == ring->next)
+			    {
+				    next = j;
+			    }
+		    }
+
+		    ring->objs.resize(j);
+		    ring->lastTicks.resize(j);
+		    ring->next = next < j ? next : 0;
+		    ring->dirty = false;
+	    }
+    }
+    //----------------------------------------------------------------------------------
+    const unsigned int GameObjectManager::DEFERRED_GROUP;
+    //----------------------------------------------------------------------------------
+    GameObjectManager::TickList::~TickList()
+    {
+	    std::vector<TickGroup*>::iterator iter;
+	    for (iter = groups.begin(); iter != groups.end(); ++iter)
+	    {
+		    delete *iter;
+	    }
+    }
+    //----------------------------------------------------------------------------------
+    GameObjectManager::ObjectType::~ObjectType()
+    {
+	    std::vector<MessageHandler*>::iterator iter;
+	    for (iter = typedHandlers.begin(); iter != typedHandlers.end(); ++iter)
+	    {
+		    delete *iter;
+	    }
+
+	    boost::unordered_map<unsigned int, MessageHandler*>::iterator codeIter;
+	    for (codeIter = codeHandlers.begin(); codeIter != codeHandlers.end(); ++codeIter)
+	    {
+		    delete codeIter->second;
+	    }
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::_setMessageHandler(unsigned int typeIndex, unsigned int code, MessageHandler *handler)
+    {
+	    if (code == 0)
+	    {
+		    delete handler;
+		    OGRE_EXCEPT(Ogre::Exception::ERR_INVALIDPARAMS, "Can't handle messages with no code!", 
+				    "NGF::GameObjectManager::_setMessageHandler()");
+	    }
+
+	    ObjectType *type = _getType(typeIndex);
+
+	    if (code >= NGF_MSG_TYPED_BASE)
+	    {
+		    unsigned int index = code - NGF_MSG_TYPED_BASE;
+		    if (index >= type->typedHandlers.size())
+		    {
+			    type->typedHandlers.resize(index + 1, 0);
+		    }
+
+		    delete type->typedHandlers[index];
+		    type->typedHandlers[index] = handler;
+	    }
+	    else
+	    {
+		    MessageHandler *&slot = type->codeHandlers[code];
+		    delete slot;
+		    slot = handler;
+	    }
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::_addToTickList(GameObject *obj, unsigned int list)
+    {
+	    if (list == TICKLIST_UNPAUSED && _isTickDeferrable(obj))
+	    {
+		    _addToDeferredRing(obj);
+		    return;
+	    }
+
+	    ObjectType *type = _getType(obj->mTypeIndex);
+	    std::vector<TickGroup*> &groups = type->tickLists[list].groups;
+
+	    unsigned int interval = obj->mTickInterval ? obj->mTickInterval : type->options.tickInterval;
+	    interval = std::max(interval, 1u);
+
+	    //Interpolation follows rendering, so it's never spread out.
+	    if (list == TICKLIST_INTERPOLATE)
+	    {
+		    interval = 1;
+	    }
+
+	    //Find the group for the interval.
+	    unsigned int g = 0;
+	    while (g < groups.size() && groups[g]->interval != interval)
+	    {
+		    ++g;
+	    }
+	    if (g == groups.size())
+	    {
+		    groups.push_back(new TickGroup(interval));
+	    }
+
+	    //Join the emptiest bucket to keep the work even across frames.
+	    TickGroup *group = groups[g];
+	    unsigned int bucket = 0;
+	    for (unsigned int b = 1; b < interval; ++b)
+	    {
+		    if (group->buckets[b].size() < group->buckets[bucket].size())
+		    {
+			    bucket = b;
+		    }
+	    }
+
+	    std::vector<GameObject*> &objs = group->buckets[bucket];
+	    obj->mTickGroups[list] = g;
+	    obj->mTickBuckets[list] = bucket;
+	    obj->mTickIndices[list] = objs.size();
+	    objs.push_back(obj);
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::_removeFromTickList(GameObject *obj, unsigned int list)
+    {
+	    if (obj->mTickGroups[list] == DEFERRED_GROUP)
+	    {
+		    _removeFromDeferredRing(obj);
+		    return;
+	    }
+
+	    TickList &tickList = _getType(obj->mTypeIndex)->tickLists[list];
+	    std::vector<GameObject*> &objs = tickList.groups[obj->mTickGroups[list]]->buckets[obj->mTickBuckets[list]];
+	    unsigned int index = obj->mTickIndices[list];
+
+	    if (mTicking)
+	    {
+		    //Don't move things around under the tick loop.
+		    objs[index] = 0;
+		    tickList.dirty = true;
+	    }
+	    else
+	    {
+		    objs[index] = objs.back();
+		    objs[index]->mTickIndices[list] = index;
+		    objs.pop_back();
+	    }
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::_compactTickLists()
+    {
+	    std::vector<ObjectType*>::iterator iter;
+
+	    for (iter = mTypes.begin(); iter != mTypes.end(); ++iter)
+	    {
+		    ObjectType *type = *iter;
+
+		    for (unsigned int list = 0; list < NUM_TICKLISTS; ++list)
+		    {
+			    TickList &tickList = type->tickLists[list];
+
+			    if (!tickList.dirty)
+			    {
+				    continue;
+			    }
+
+			    //Remove the NULLs, keeping the order.
+			    for (unsigned int g = 0; g < tickList.groups.size(); ++g)
+			    {
+				    TickGroup *group = tickList.groups[g];
+
+				    for (unsigned int b = 0; b < group->interval; ++b)
+				    {
+					    std::vector<GameObject*> &objs = group->buckets[b];
+					    unsigned int j = 0;
+
+					    for (unsigned int i = 0; i < objs.size(); ++i)
+					    {
+						    if (objs[i])
+						    {
+							    objs[j] = objs[i];
+							    objs[j]->mTickIndices[list] = j;
+							    ++j;
+						    }
+					    }
+
+					    objs.resize(j);
+				    }
+			    }
+
+			    tickList.dirty = false;
+		    }
+	    }
+
+	    _compactDeferredRings(false);
+    }
+    //----------------------------------------------------------------------------------
+    std::vector<GameObject*> GameObjectManager::createObjects(const ObjectSpawn *spawns, unsigned int numSpawns)
+    {
+	    std::vector<GameObject*> created;
+	    created.reserve(numSpawns);
+
+	    //From a parallel tick, each creation is recorded.
+	    if (mParallelPhase && _getCommandBuffer())
+	    {
+		    for (unsigned int i = 0; i < numSpawns; ++i)
+		    {
+			    const ObjectSpawn &spawn = spawns[i];
+			    created.push_back(createObject(spawn.type, spawn.pos, spawn.rot, spawn.properties, spawn.name));
+		    }
+		    return created;
+	    }
+
+	    //Find the create functions, once per type, and check the names against the 
+	    //existing GameObjects and each other.
+	    typedef boost::unordered_map<Ogre::String, GameObjectFactory::IDCreateFunction> FunctionMap;
+	    FunctionMap functions;
+	    std::vector<GameObjectFactory::IDCreateFunction> spawnFunctions(numSpawns);
+	    NameMap names;
+
+	    for (unsigned int i = 0; i < numSpawns; ++i)
+	    {
+		    const ObjectSpawn &spawn = spawns[i];
+
+		    FunctionMap::iterator found = functions.find(spawn.type);
+		    if (found == functions.end())
+		    {
+			    found = functions.insert(FunctionMap::value_type(spawn.type, 
+						    mObjectFactory->_getIDCreateFunction(spawn.type))).first;
+		    }
+		    spawnFunctions[i] = found->second;
+
+		    if (spawn.name.empty() || spawn.name == "noname" || !found->second)
+		    {
+			    continue;
+		    }
+
+		    if (mNameMap.find(spawn.name) != mNameMap.end() || !names.insert(NameMap::value_type(spawn.name, 0)).second)
+		    {
+			    OGRE_EXCEPT(Ogre::Exception::ERR_DUPLICATE_ITEM, "GameObject with name'" 
+					    + spawn.name + "' already exists!", "NGF::GameObjectManager::createObjects()");
+		    }
+	    }
+
+	    //Make room for all of them.
+	    unsigned int numNew = numSpawns > mFreeSlots.size() ? numSpawns - mFreeSlots.size() : 0;
+	    mSlots.reserve(mSlots.size() + numNew);
+	    mNameMap.rehash((std::size_t) ((mNameMap.size() + names.size()) / mNameMap.max_load_factor()) + 1);
+
+	    for (unsigned int i = 0; i < numSpawns; ++i)
+	    {
+		    const ObjectSpawn &spawn = spawns[i];
+
+		    if (!spawnFunctions[i])
+		    {
+			    created.push_back(NULL);
+			    continue;
+		    }
+
+		    created.push_back(spawnFunctions[i](_nextFreeID(), spawn.pos, spawn.rot, spawn.properties, spawn.name));
+	    }
+
+	    return created;
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::_partitionTickLists()
+    {
+	    //Keep what's still managed, in order, and drop the rest. If nothing is left
+	    //there's no need to look at the GameObjects.
+	    bool keepAny = mNumObjects > 0;
+	    std::vector<ObjectType*>::iterator iter;
+
+	    for (iter = mTypes.begin(); iter != mTypes.end(); ++iter)
+	    {
+		    for (unsigned int list = 0; list < NUM_TICKLISTS; ++list)
+		    {
+			    TickList &tickList = (*iter)->tickLists[list];
+
+			    for (unsigned int g = 0; g < tickList.groups.size(); ++g)
+			    {
+				    TickGroup *group = tickList.groups[g];
+
+				    for (unsigned int b = 0; b < group->interval; ++b)
+				    {
+					    std::vector<GameObject*> &objs = group->buckets[b];
+					    unsigned int j = 0;
+
+					    for (unsigned int i = 0; keepAny && i < objs.size(); ++i)
+					    {
+						    if (objs[i] && objs[i]->mManaged)
+						    {
+							    objs[j] = objs[i];
+							    objs[j]->mTickIndices[list] = j;
+							    ++j;
+						    }
+					    }
+
+					    objs.resize(j);
+				    }
+			    }
+
+			    tickList.dirty = false;
+		    }
+	    }
+
+	    _compactDeferredRings(true);
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::_partitionIndices()
+    {
+	    //Like _partitionTickLists.
+	    bool keepAny = mNumObjects > 0;
+
+	    std::vector<ObjectType*>::iterator iter;
+	    for (iter = mTypes.begin(); iter != mTypes.end(); ++iter)
+	    {
+		    std::vector<GameObject*> &objs = (*iter)->members;
+		    unsigned int j = 0;
+
+		    for (unsigned int i = 0; keepAny && i < objs.size(); ++i)
+		    {
+			    if (objs[i]->mManaged)
+			    {
+				    objs[j] = objs[i];
+				    objs[j]->mTypeMemberIndex = j;
+				    ++j;
+			    }
+		    }
+
+		    objs.resize(j);
+	    }
+
+	    for (FlagID flag = 0; flag < mFlagMembers.size(); ++flag)
+	    {
+		    std::vector<GameObject*> &objs = mFlagMembers[flag];
+		    unsigned int j = 0;
+
+		    for (unsigned int i = 0; keepAny && i < objs.size(); ++i)
+		    {
+			    GameObject *obj = objs[i];
+
+			    if (obj->mManaged)
+			    {
+				    for (unsigned int k = 0; k < obj->mFlagIndices.size(); ++k)
+				    {
+					    if (obj->mFlagIndices[k].first == flag)
+					    {
+						    obj->mFlagIndices[k].second = j;
+					    }
+				    }
+
+				    objs[j++] = obj;
+			    }
+		    }
+
+		    objs.resize(j);
+	    }
+    }
+    //----------------------------------------------------------------------------------
+    bool GameObjectManager::destroyObject(ID objID)
+    {
+	    GameObject *obj = getByID(objID);
+
+	    if (obj && mParallelPhase)
+	    {
+		    if (CommandBuffer *cmds = _getCommandBuffer())
+		    {
+			    cmds->add(CommandBuffer::Command::DESTROY).id = objID;
+			    return true;
+		    }
+	    }
+
+	    if (!obj)
+	    {
+		    return false;
+	    }
+	    else
+	    {
+		    NGF_PROFILE(obj, PROFILE_DESTROY);
+
+		    //Keep the tick flags for when it is used again.
+		    unsigned int tickFlags = obj->mTickFlags;
+		    _removeObject(getIDIndex(objID));
+
+		    if (_getType(obj->mTypeIndex)->options.recycleCount)
+		    {
+			    obj->mTickFlags = tickFlags;
+			    obj->deactivate();
+
+			    if (_recycleObject(obj))
+			    {
+				    return true;
+			    }
+		    }
+
+		    obj->destroy(); //For scripting, as scripting languages are GCed.
+		    _freeObject(obj);
+
+		    return true;
+	    }
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::destroyAll(void)
+    {
+	    //Take everything that's going out in one pass. mDestroyList keeps its memory from
+	    //last time. Names are erased one by one only if some named GameObjects stay.
+	    mDestroyList.clear();
+	    mFreeSlots.clear();
+	    bool keepNames = false;
+
+	    for (unsigned int i = mSlots.size(); i-- > 0; )
+	    {
+                GameObject *obj = mSlots[i].obj;
+
+                if (obj && obj->isPersistent()) //If it doesn't want to die...
+                {
+                    keepNames = keepNames || !obj->mName.empty();
+                    continue;
+                }
+
+                if (obj)
+                {
+                    if (mTicking)
+                    {
+                        _setTickFlags(obj, TICK_NONE);
+                    }
+                    if (hasTransform(obj))
+                    {
+                        removeTransform(obj);
+                    }
+                    if (obj->mFirstTask != ~0u)
+                    {
+                        mTaskWheel->cancelOwned(obj);
+                    }
+                    obj->mManaged = false;
+                    mDestroyList.push_back(obj);
+
+                    //Bump the generation so IDs referring to the old GameObject become stale.
+                    mSlots[i].obj = 0;
+                    mSlots[i].generation = (mSlots[i].generation + 1) & ((1u << NGF_ID_GENERATION_BITS) - 1);
+                }
+                else if (mSlots[i].reserved)
+                {
+                    //Still being created, it isn't free.
+                    continue;
+                }
+
+                //Lowest index ends up on top.
+                mFreeSlots.push_back(i);
+	    }
+	    mNumObjects -= mDestroyList.size();
+
+	    if (keepNames)
+	    {
+		    for (unsigned int i = 0; i < mDestroyList.size(); ++i)
+		    {
+			    if (!mDestroyList[i]->mName.empty())
+			    {
+				    mNameMap.erase(mDestroyList[i]->mName);
+			    }
+		    }
+	    }
+	    else
+	    {
+		    mNameMap.clear();
+	    }
+
+	    if (!mTicking)
+	    {
+		    _partitionTickLists();
+	    }
+	    _partitionIndices();
+	    _partitionSubscriptions();
+
+	    std::vector<DestroyAllFunction>::iterator listener;
+	    for (listener = mDestroyAllListeners.begin(); listener != mDestroyAllListeners.end(); ++listener)
+	    {
+		    (*listener)(mDestroyList);
+	    }
+
+	    //Now they can go.
+	    for (unsigned int i = 0; i < mDestroyList.size(); ++i)
+	    {
+		    NGF_PROFILE(mDestroyList[i], PROFILE_DESTROY);
+		    _freeObject(mDestroyList[i]);
+	    }
+	    mDestroyList.clear();
+
+	    clearRecycled();
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::addDestroyAllListener(DestroyAllFunction func)
+    {
+	    mDestroyAllListeners.push_back(func);
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::removeDestroyAllListener(DestroyAllFunction func)
+    {
+	    std::vector<DestroyAllFunction>::iterator iter = 
+		    std::find(mDestroyAllListeners.begin(), mDestroyAllListeners.end(), func);
+
+	    if (iter != mDestroyAllListeners.end())
+	    {
+		    mDestroyAllListeners.erase(iter);
+	    }
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::clearRecycled(void)
+    {
+	    std::vector<ObjectType*>::iterator iter;
+	    for (iter = mTypes.begin(); iter != mTypes.end(); ++iter)
+	    {
+		    std::vector<GameObject*> &recycled = (*iter)->recycled;
+
+		    for (unsigned int i = 0; i < recycled.size(); ++i)
+		    {
+			    recycled[i]->destroy();
+			    _freeObject(recycled[i]);
+		    }
+		    recycled.clear();
+	    }
+    }
+    //----------------------------------------------------------------------------------
+    bool GameObjectManager::_recycleObject(GameObject *obj)
+    {
+	    ObjectType *type = _getType(obj->mTypeIndex);
+
+	    if (type->recycled.size() >= type->options.recycleCount)
+	    {
+		    return false;
+	    }
+
+	    type->recycled.push_back(obj);
+	    return true;
+    }
+    //----------------------------------------------------------------------------------
+    GameObject *GameObjectManager::_reuseObject(unsigned int typeIndex, ID id, const Ogre::Vector3 &pos, 
+		    const Ogre::Quaternion &rot, const PropertyList &properties, const Ogre::String &name)
+    {
+	    std::vector<GameObject*> &recycled = _getType(typeIndex)->recycled;
+
+	    if (recycled.empty())
+	    {
+		    return NULL;
+	    }
+
+	    GameObject *obj = recycled.back();
+	    recycled.pop_back();
+
+	    //What it was given in its last life goes, what its constructor gave it it gets again
+	    //in 'reactivate'. It's out of the flag indices, so they needn't be told.
+	    obj->mID = id;
+	    obj->mName = name;
+	    obj->mProperties = properties;
+	    obj->mFlags.reset();
+	    obj->mPersistent = false;
+	    obj->mTickInterval = 0;
+	    obj->mTickDeferrable = -1;
+	    obj->mTickPriority = 0;
+
+	    try
+	    {
+		    obj->reactivate(pos, rot, properties);
+	    }
+	    catch (...)
+	    {
+		    _forgetObject(obj);
+		    obj->destroy();
+		    _freeObject(obj);
+		    throw;
+	    }
+
+	    _insertObject(obj, pos, rot);
+	    return obj;
+    }
+    //----------------------------------------------------------------------------------
+    GameObject* GameObjectManager::getByID(ID objID) const
+    {
+	    unsigned int index = getIDIndex(objID);
+
+	    if (index >= mSlots.size())
+	    {
+		    return NULL;
+	    }
+
+	    const ObjectSlot &slot = mSlots[index];
+	    return (slot.generation == getIDGeneration(objID)) ? slot.obj : NULL;
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::forEachGameObject(ForEachFunction func)
+    {
+	    for (unsigned int i = 0; i < mSlots.size(); ++i)
+	    {
+		    if (mSlots[i].obj)
+		    {
+			    func(mSlots[i].obj);
+		    }
+	    }
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::sendMessage(GameObject *obj, const Message &msg) const
+    {
+	    if (obj)
+	    {
+		    if (mParallelPhase)
+		    {
+			    if (CommandBuffer *cmds = _getCommandBuffer())
+			    {
+				    CommandBuffer::Command &cmd = cmds->add(CommandBuffer::Command::SEND_MESSAGE);
+				    cmd.id = obj->getID();
+				    cmd.msg = msg;
+				    return;
+			    }
+		    }
+
+		    _dispatchMessage(obj, msg);
+	    }
+    }
+    //----------------------------------------------------------------------------------
+    bool GameObjectManager::postMessageByID(ID objID, const Message &msg)
+    {
+	    if (mParallelPhase)
+	    {
+		    if (CommandBuffer *cmds = _getCommandBuffer())
+		    {
+			    CommandBuffer::Command &cmd = cmds->add(CommandBuffer::Command::POST_MESSAGE);
+			    cmd.id = objID;
+			    cmd.msg = msg;
+			    return true;
+		    }
+	    }
+
+	    return _postMessage(objID, msg, ~0u);
+    }
+    //----------------------------------------------------------------------------------
+    bool GameObjectManager::_postMessage(ID objID, const Message &msg, unsigned int request)
+    {
+	    if (mMessageQueueCapacity && mPosted.size() >= mMessageQueueCapacity)
+	    {
+		    ++mQueueStats.numDropped;
+		    return false;
+	    }
+
+	    mPostedMessages.push_back(msg);
+	    mPosted.push_back(PostedMessage(objID, mPostedMessages.size() - 1, request));
+	    ++mQueueStats.numPosted;
+	    mQueueStats.peakQueued = std::max(mQueueStats.peakQueued, (unsigned int) mPosted.size());
+
+	    return true;
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::deliverMessages()
+    {
+	    completeRequests();
+
+	    if (mPosted.empty() || !mDelivering.empty())
+	    {
+		    //Nothing to do, or we're already delivering (called from a handler).
+		    return;
+	    }
+
+	    mDelivering.swap(mPosted);
+	    mDeliveringMessages.swap(mPostedMessages);
+	    ++mQueueStats.numDeliveries;
+
+	    //Group by slot, keeping the order for each GameObject. Only the keys are sorted.
+	    mDeliveryOrder.resize(mDelivering.size());
+	    for (unsigned int i = 0; i < mDelivering.size(); ++i)
+	    {
+		    mDeliveryOrder[i] = std::make_pair(getIDIndex(mDelivering[i].to), i);
+	    }
+	    std::sort(mDeliveryOrder.begin(), mDeliveryOrder.end());
+
+	    try
+	    {
+		    for (unsigned int i = 0; i < mDeliveryOrder.size(); ++i)
+		    {
+			    const PostedMessage &posted = mDelivering[mDeliveryOrder[i].second];
+
+			    if (GameObject *obj = getByID(posted.to))
+			    {
+				    if (posted.request == ~0u)
+				    {
+					    _dispatchMessage(obj, mDeliveringMessages[posted.msg]);
+				    }
+				    else
+				    {
+					    _deliverRequest(obj, posted.request, mDeliveringMessages[posted.msg]);
+				    }
+				    ++mQueueStats.numDelivered;
+			    }
+			    else
+			    {
+				    if (posted.request != ~0u)
+				    {
+					    _completeRequest(posted.request, REPLY_NO_OBJECT, MessageReply());
+				    }
+				    ++mQueueStats.numStale;
+			    }
+		    }
+	    }
+	    catch (...)
+	    {
+		    //The rest are dropped.
+		    mCurrentRequest = ~0u;
+		    mDelivering.clear();
+		    mDeliveringMessages.clear();
+		    throw;
+	    }
+
+	    mDelivering.clear();
+	    mDeliveringMessages.clear();
+
+	    //Some may have been fulfilled while delivering.
+	    completeRequests();
+    }
+    //----------------------------------------------------------------------------------
+    RequestTicket GameObjectManager::requestReply(GameObject *to, const Message &msg, ReplyFunction onReply, 
+		    GameObject *from)
+    {
+	    if (mParallelPhase && _getCommandBuffer())
+	    {
+		    OGRE_EXCEPT(Ogre::Exception::ERR_INVALID_STATE, "Can't request a reply in a parallel tick!", 
+				    "NGF::GameObjectManager::requestReply()");
+	    }
+
+	    unsigned int index;
+	    if (mFreeRequests.empty())
+	    {
+		    index = mRequests.size();
+		    mRequests.push_back(RequestSlot());
+	    }
+	    else
+	    {
+		    index = mFreeRequests.back();
+		    mFreeRequests.pop_back();
+	    }
+
+	    RequestSlot &req = mRequests[index];
+	    req.used = true;
+	    req.deferred = false;
+	    req.status = REPLY_PENDING;
+	    req.onReply = onReply;
+	    req.from = from;
+	    req.fromID = from ? from->getID() : 0;
+
+	    RequestTicket ticket(index, req.generation);
+
+	    if (!to)
+	    {
+		    _completeRequest(index, REPLY_NO_OBJECT, MessageReply());
+	    }
+	    else if (!_postMessage(to->getID(), msg, index))
+	    {
+		    _completeRequest(index, REPLY_DROPPED, MessageReply());
+	    }
+
+	    return ticket;
+    }
+    //----------------------------------------------------------------------------------
+    RequestTicket GameObjectManager::deferReply()
+    {
+	    if (mCurrentRequest == ~0u)
+	    {
+		    OGRE_EXCEPT(Ogre::Exception::ERR_INVALID_STATE, "Not handling a request!", 
+				    "NGF::GameObjectManager::deferReply()");
+	    }
 
-            insert(PropertyPair(key, vals));
-            return *this;
+	    RequestSlot &req = mRequests[mCurrentRequest];
+	    req.deferred = true;
+
+	    return RequestTicket(mCurrentRequest, req.generation);
     }
     //----------------------------------------------------------------------------------
-    PropertyList PropertyList::create(Ogre::String key, Ogre::String values, Ogre::String delims)
+    void GameObjectManager::fulfilRequest(const RequestTicket &ticket, const MessageReply &reply)
     {
-	    NGF::PropertyList props;
-	    props.addProperty(key, values, delims);
-	    return props;
+	    boost::mutex::scoped_lock lock(mReplyQueue->mutex);
+	    mReplyQueue->replies.push_back(std::make_pair(ticket, reply));
     }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::completeRequests()
+    {
+	    ReplyQueue::Replies &taken = mReplyQueue->taken;
 
-/*
- * =====================================================================================
- * NGF::GameObject
- * =====================================================================================
- */
+	    if (!taken.empty())
+	    {
+		    //Called from a callback.
+		    return;
+	    }
 
-    GameObject* GameObject::addFlag(Ogre::String flag)
-    {
-	    if (mFlags.empty())
 	    {
-		    mFlags = "|";
+		    boost::mutex::scoped_lock lock(mReplyQueue->mutex);
+		    taken.swap(mReplyQueue->replies);
 	    }
-	    mFlags += (flag + "|");
 
-	    return this;
+	    try
+	    {
+		    for (unsigned int i = 0; i < taken.size(); ++i)
+		    {
+			    const RequestTicket &ticket = taken[i].first;
+
+			    //Only deferred requests still waiting take replies.
+			    if (_isRequest(ticket) && mRequests[ticket.index].deferred 
+					    && mRequests[ticket.index].status == REPLY_PENDING)
+			    {
+				    const MessageReply &reply = taken[i].second;
+				    _completeRequest(ticket.index, reply.empty() ? REPLY_NONE : REPLY_OK, reply);
+			    }
+		    }
+	    }
+	    catch (...)
+	    {
+		    //The rest are dropped.
+		    taken.clear();
+		    throw;
+	    }
+
+	    taken.clear();
     }
     //----------------------------------------------------------------------------------
-    bool GameObject::removeFlag(Ogre::String flag)
+    void GameObjectManager::_deliverRequest(GameObject *obj, unsigned int request, const Message &msg)
     {
-	    std::string::size_type pos1 = mFlags.find("|" + flag + "|");
+	    //A released request is just a message.
+	    if (!mRequests[request].used || mRequests[request].status != REPLY_PENDING)
+	    {
+		    _dispatchMessage(obj, msg);
+		    return;
+	    }
+
+	    mCurrentRequest = request;
+	    MessageReply reply = _dispatchMessage(obj, msg);
+	    mCurrentRequest = ~0u;
 
-	    if (pos1 == Ogre::String::npos)
+	    if (!mRequests[request].deferred)
 	    {
-		    return false;
+		    _completeRequest(request, reply.empty() ? REPLY_NONE : REPLY_OK, reply);
 	    }
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::_completeRequest(unsigned int request, ReplyStatus status, const MessageReply &reply)
+    {
+	    RequestSlot &req = mRequests[request];
+	    req.status = status;
+	    req.reply = reply;
 
-	    ++pos1;
-	    std::string::size_type pos2 = flag.length() + 1;
+	    if (req.onReply)
+	    {
+		    //Released first, so the callback can make requests of its own.
+		    ReplyFunction onReply = req.onReply;
+		    RequestTicket ticket(request, req.generation);
+		    bool fromGone = req.from && getByID(req.fromID) != req.from;
+		    MessageReply given = reply;
 
-	    mFlags.erase(pos1, pos2);
+		    _releaseRequest(request);
 
-	    return true;
+		    if (!fromGone)
+		    {
+			    onReply(ticket, status, given);
+		    }
+	    }
     }
     //----------------------------------------------------------------------------------
-    bool GameObject::hasFlag(Ogre::String flag) const
+    void GameObjectManager::_releaseRequest(unsigned int request)
     {
-	    return !(mFlags.find("|" + flag + "|") == Ogre::String::npos);
+	    RequestSlot &req = mRequests[request];
+	    req.used = false;
+	    req.reply = MessageReply();
+	    req.onReply.clear();
+	    ++req.generation;
+	    mFreeRequests.push_back(request);
     }
+    //----------------------------------------------------------------------------------
+    TaskWheel *GameObjectManager::_getTaskWheel()
+    {
+	    if (!mTaskWheel)
+	    {
+		    mTaskWheel = new TaskWheel(mTaskResolution);
+	    }
 
-/*
- * =====================================================================================
- * NGF::GameObjectFactory
- * =====================================================================================
- */
+	    return mTaskWheel;
+    }
+    //----------------------------------------------------------------------------------
+    TaskHandle GameObjectManager::scheduleTask(Ogre::Real delay, TaskFunction func, GameObject *owner)
+    {
+	    if (mParallelPhase && _getCommandBuffer())
+	    {
+		    OGRE_EXCEPT(Ogre::Exception::ERR_INVALID_STATE, "Can't schedule a task in a parallel tick!", 
+				    "NGF::GameObjectManager::scheduleTask()");
+	    }
 
-    GameObjectFactory& GameObjectFactory::getSingleton(void)
+	    return _getTaskWheel()->schedule(delay, func, owner);
+    }
+    //----------------------------------------------------------------------------------
+    bool GameObjectManager::cancelTask(const TaskHandle &task)
     {
-	    assert(msSingleton); return *msSingleton;
+	    return mTaskWheel && mTaskWheel->cancel(task);
     }
-    GameObjectFactory* GameObjectFactory::getSingletonPtr(void)
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::cancelTasks(GameObject *owner)
     {
-	    return msSingleton;
+	    if (owner->mFirstTask != ~0u)
+	    {
+		    mTaskWheel->cancelOwned(owner);
+	    }
     }
     //----------------------------------------------------------------------------------
-    GameObject* GameObjectFactory::createObject(Ogre::String type, Ogre::Vector3 pos, Ogre::Quaternion rot, PropertyList props, Ogre::String name)
+    bool GameObjectManager::isTaskPending(const TaskHandle &task) const
     {
-	    CreateFunctionMap::iterator iter = mCreateFunctions.find(type);
+	    return mTaskWheel && mTaskWheel->isPending(task);
+    }
+    //----------------------------------------------------------------------------------
+    Ogre::Real GameObjectManager::getTaskTimeLeft(const TaskHandle &task) const
+    {
+	    return mTaskWheel ? mTaskWheel->getTimeLeft(task) : -1;
+    }
+    //----------------------------------------------------------------------------------
+    unsigned int GameObjectManager::getNumTasks() const
+    {
+	    return mTaskWheel ? mTaskWheel->getNumTasks() : 0;
+    }
+    //----------------------------------------------------------------------------------
+    Ogre::Real GameObjectManager::getTaskTime() const
+    {
+	    return mTaskWheel ? mTaskWheel->getTime() : 0;
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::setTaskResolution(Ogre::Real seconds)
+    {
+	    if (seconds <= 0)
+	    {
+		    OGRE_EXCEPT(Ogre::Exception::ERR_INVALIDPARAMS, "Task resolution must be positive!", 
+				    "NGF::GameObjectManager::setTaskResolution()");
+	    }
+	    if (getNumTasks())
+	    {
+		    OGRE_EXCEPT(Ogre::Exception::ERR_INVALID_STATE, "Can't change the task resolution while tasks "
+				    "are pending!", "NGF::GameObjectManager::setTaskResolution()");
+	    }
 
-	    if (iter != mCreateFunctions.end())
-		    return iter->second(pos, rot, props, name); //Found.
-	    return 0; //Not found.
+	    mTaskResolution = seconds;
+	    if (mTaskWheel)
+	    {
+		    mTaskWheel->setResolution(seconds);
+	    }
     }
     //----------------------------------------------------------------------------------
-    GameObject* GameObjectFactory::_createObject(Ogre::String type, ID id, Ogre::Vector3 pos, Ogre::Quaternion rot, PropertyList props, Ogre::String name)
+    void GameObjectManager::advanceTasks(Ogre::Real time)
     {
-	    IDCreateFunctionMap::iterator iter = mIDCreateFunctions.find(type);
+	    TaskWheel *wheel = _getTaskWheel();
+	    if (wheel->isAdvancing())
+	    {
+		    OGRE_EXCEPT(Ogre::Exception::ERR_INVALID_STATE, "Can't advance tasks from a task!", 
+				    "NGF::GameObjectManager::advanceTasks()");
+	    }
 
-	    if (iter != mIDCreateFunctions.end())
-		    return iter->second(id, pos, rot, props, name); //Found.
-	    return 0; //Not found.
+	    wheel->advance(time);
     }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::setProfiling(bool enable)
+    {
+	    //Tick workers read the flag without locking, so it can't change under them.
+	    if (mParallelPhase)
+	    {
+		    OGRE_EXCEPT(Ogre::Exception::ERR_INVALID_STATE, "Can't turn profiling on or off in a parallel tick!", 
+				    "NGF::GameObjectManager::setProfiling()");
+	    }
 
-/*
- * =====================================================================================
- * NGF::GameObjectManager
- * =====================================================================================
- */
+	    if (enable && !mProfiler)
+	    {
+		    mProfiler = new Profiler();
+	    }
 
-    GameObjectManager* GameObjectManager::getSingletonPtr(void)
-    {
-	    return msSingleton;
+	    ProfileScope::msEnabled = enable;
     }
-    GameObjectManager& GameObjectManager::getSingleton(void)
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::setProfileTracing(bool enable, unsigned int maxEvents)
     {
-	    assert(msSingleton); return *msSingleton;
+	    if (!mProfiler)
+	    {
+		    mProfiler = new Profiler();
+	    }
+
+	    mProfiler->tracing = enable;
+	    mProfiler->maxEvents = maxEvents;
+	    if (mProfiler->events.capacity() < maxEvents && enable)
+	    {
+		    //Up front, so growing doesn't show up in the trace.
+		    mProfiler->events.reserve(std::min(maxEvents, 1u << 16));
+	    }
     }
     //----------------------------------------------------------------------------------
-    GameObjectManager::GameObjectManager()
-	    : mObjectFactory(new GameObjectFactory())
+    ProfileStats GameObjectManager::getProfileStats(const Ogre::String &type) const
     {
+	    if (!mProfiler)
+	    {
+		    return ProfileStats();
+	    }
+	    if (type.empty())
+	    {
+		    return mProfiler->untyped;
+	    }
+
+	    for (unsigned int i = 0; i < mTypes.size() && i < mProfiler->stats.size(); ++i)
+	    {
+		    if (mTypes[i]->name == type)
+		    {
+			    return mProfiler->stats[i];
+		    }
+	    }
+	    return ProfileStats();
     }
     //----------------------------------------------------------------------------------
-    void GameObjectManager::tick(bool paused, const Ogre::FrameEvent & evt)
+    std::vector<std::pair<Ogre::String, ProfileStats> > GameObjectManager::getProfileStats() const
     {
-	    std::map<ID,GameObject*>::iterator objIter;
-
-	    for (objIter = mGameObjectMap.begin();
-			    objIter != mGameObjectMap.end(); ++objIter)
+	    std::vector<std::pair<Ogre::String, ProfileStats> > result;
+	    if (!mProfiler)
 	    {
-		    GameObject *obj = objIter->second;
+		    return result;
+	    }
 
-		    if (paused)
+	    if (!profileStatsEmpty(mProfiler->untyped))
+	    {
+		    result.push_back(std::make_pair(Ogre::String(), mProfiler->untyped));
+	    }
+	    for (unsigned int i = 0; i < mTypes.size() && i < mProfiler->stats.size(); ++i)
+	    {
+		    if (!profileStatsEmpty(mProfiler->stats[i]))
 		    {
-			    obj->pausedTick(evt);
+			    result.push_back(std::make_pair(mTypes[i]->name, mProfiler->stats[i]));
 		    }
-		    else
+	    }
+	    return result;
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::resetProfile()
+    {
+	    if (mProfiler)
+	    {
+		    mProfiler->stats.clear();
+		    mProfiler->untyped = ProfileStats();
+		    mProfiler->events.clear();
+		    mProfiler->numDropped = 0;
+	    }
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::writeProfileTrace(const Ogre::String &filename) const
+    {
+	    std::ofstream out(filename.c_str());
+	    if (!out)
+	    {
+		    OGRE_EXCEPT(Ogre::Exception::ERR_CANNOT_WRITE_TO_FILE, "Can't write profile trace '" + filename + "'!", 
+				    "NGF::GameObjectManager::writeProfileTrace()");
+	    }
+
+	    writeProfileTrace(out);
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::writeProfileTrace(std::ostream &out) const
+    {
+	    static const char *categoryNames[NUM_PROFILE_CATEGORIES] = 
+		    { "tick", "message", "create", "destroy", "python", "load" };
+
+	    std::ios::fmtflags flags = out.flags();
+	    out << std::fixed << std::setprecision(3);
+	    out << "{\"traceEvents\":[";
+
+	    //Complete events, with times in microseconds.
+	    std::set<unsigned int> threads;
+	    const char *comma = "\n";
+	    if (mProfiler)
+	    {
+		    std::vector<Profiler::Event>::const_iterator iter;
+		    for (iter = mProfiler->events.begin(); iter != mProfiler->events.end(); ++iter)
 		    {
-			    obj->unpausedTick(evt);
+			    const char *type = iter->typeIndex < mTypes.size() ? mTypes[iter->typeIndex]->name.c_str() : "";
+			    const char *name = iter->label ? iter->label : *type ? type : "GameObjectManager";
+
+			    out << comma << "{\"name\":";
+			    writeJSONString(out, name);
+			    out << ",\"cat\":\"" << categoryNames[iter->category] << "\",\"ph\":\"X\",\"ts\":" 
+				    << iter->start * 1e6 << ",\"dur\":" << iter->duration * 1e6 
+				    << ",\"pid\":1,\"tid\":" << iter->thread << ",\"args\":{\"type\":";
+			    writeJSONString(out, type);
+			    out << ",\"calls\":" << iter->calls << "}}";
+
+			    threads.insert(iter->thread);
+			    comma = ",\n";
 		    }
 	    }
 
-	    std::vector<ID>::iterator iter;
-
-	    for (iter = mObjectsToDestroy.begin();
-			    iter != mObjectsToDestroy.end(); ++iter)
+	    //Name the threads.
+	    for (std::set<unsigned int>::iterator thread = threads.begin(); thread != threads.end(); ++thread)
 	    {
-		    destroyObject(*iter);
+		    out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << *thread 
+			    << ",\"args\":{\"name\":\"";
+		    if (*thread)
+			    out << "Tick worker " << *thread << "\"}}";
+		    else
+			    out << "Main\"}}";
 	    }
-	    mObjectsToDestroy.clear();
+
+	    out << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedEvents\":" 
+		    << (mProfiler ? mProfiler->numDropped : 0) << "}}\n";
+	    out.flags(flags);
     }
     //----------------------------------------------------------------------------------
-    bool GameObjectManager::destroyObject(ID objID)
+    unsigned int GameObjectManager::sendMessageToGroup(ObjectRange group, const Message &msg)
     {
-	    std::map<ID,GameObject*>::iterator objIter = mGameObjectMap.find(objID);
+	    //From a parallel tick, each is recorded.
+	    if (mParallelPhase && _getCommandBuffer())
+	    {
+		    for (ObjectIterator iter = group.first; iter != group.second; ++iter)
+		    {
+			    sendMessage(*iter, msg);
+		    }
+
+		    return group.second - group.first;
+	    }
 
-	    if (objIter == mGameObjectMap.end())
+	    //Handlers may change the group, so go by the IDs. Groups sent to from handlers
+	    //find mGroupIDs taken and get vectors of their own.
+	    std::vector<ID> ids;
+	    ids.swap(mGroupIDs);
+	    ids.clear();
+
+	    for (ObjectIterator iter = group.first; iter != group.second; ++iter)
 	    {
-		    return false;
+		    ids.push_back((*iter)->getID());
 	    }
-	    else
+
+	    //Groups are mostly of one type, so the handler is only looked up when it changes.
+	    unsigned int numSent = 0;
+	    unsigned int typeIndex = ~0u;
+	    MessageHandler *handler = 0;
+
+	    for (std::vector<ID>::iterator iter = ids.begin(); iter != ids.end(); ++iter)
 	    {
-		    GameObject *obj = objIter->second;
+		    GameObject *obj = getByID(*iter);
 
-		    mGameObjectMap.erase(objIter);
-		    obj->destroy(); //For scripting, as scripting languages are GCed.
-		    delete obj;
+		    if (!obj)
+		    {
+			    continue;
+		    }
 
-		    return true;
+		    if (obj->mTypeIndex != typeIndex)
+		    {
+			    typeIndex = obj->mTypeIndex;
+			    handler = _getMessageHandler(obj, msg.code);
+		    }
+
+		    NGF_PROFILE(obj, PROFILE_MESSAGE);
+		    if (handler)
+		    {
+			    handler->handle(obj, msg);
+		    }
+		    else
+		    {
+			    obj->receiveMessage(msg);
+		    }
+		    ++numSent;
+	    }
+
+	    if (ids.capacity() > mGroupIDs.capacity())
+	    {
+		    ids.swap(mGroupIDs);
 	    }
+
+	    return numSent;
     }
     //----------------------------------------------------------------------------------
-    void GameObjectManager::destroyAll(void)
+    unsigned int GameObjectManager::postMessageToGroup(ObjectRange group, const Message &msg)
     {
-	    std::map<ID,GameObject*>::iterator objIter;
+	    unsigned int numObjs = group.second - group.first;
 
-            std::map<ID,GameObject*> persistentObjects;
+	    if (numObjs == 0)
+	    {
+		    return 0;
+	    }
 
-	    for (objIter = mGameObjectMap.begin();
-			    objIter != mGameObjectMap.end();)
+	    if (mParallelPhase && _getCommandBuffer())
 	    {
-                GameObject *obj = objIter->second;
+		    for (ObjectIterator iter = group.first; iter != group.second; ++iter)
+		    {
+			    postMessageByID((*iter)->getID(), msg);
+		    }
 
-                if (obj->isPersistent()) //If it doesn't want to die...
-		    persistentObjects.insert(*objIter);
-                else
-                    delete obj;
+		    return numObjs;
+	    }
+
+	    if (mMessageQueueCapacity && mPosted.size() + numObjs > mMessageQueueCapacity)
+	    {
+		    mQueueStats.numDropped += numObjs;
+		    return 0;
+	    }
 
-                mGameObjectMap.erase(objIter++);
+	    mPostedMessages.push_back(msg);
+	    unsigned int msgIndex = mPostedMessages.size() - 1;
+
+	    for (ObjectIterator iter = group.first; iter != group.second; ++iter)
+	    {
+		    mPosted.push_back(PostedMessage((*iter)->getID(), msgIndex));
 	    }
 
-            mGameObjectMap = persistentObjects;
+	    mQueueStats.numPosted += numObjs;
+	    mQueueStats.peakQueued = std::max(mQueueStats.peakQueued, (unsigned int) mPosted.size());
+
+	    return numObjs;
     }
     //----------------------------------------------------------------------------------
-    GameObject* GameObjectManager::getByID(ID objID) const
+    ChannelID GameObjectManager::getChannel(const Ogre::String &name)
     {
-	    std::map<ID,GameObject*>::const_iterator objIter = mGameObjectMap.find(objID);
+	    boost::unordered_map<Ogre::String, ChannelID>::iterator iter = mChannelIDs.find(name);
 
-	    return (objIter == mGameObjectMap.end()) ? NULL : objIter->second;
+	    if (iter != mChannelIDs.end())
+	    {
+		    return iter->second;
+	    }
+
+	    ChannelID channel = mChannels.size();
+	    mChannels.push_back(new Channel());
+	    mChannels.back()->name = name;
+	    mChannelIDs[name] = channel;
+
+	    return channel;
     }
     //----------------------------------------------------------------------------------
-    void GameObjectManager::forEachGameObject(ForEachFunction func)
+    Subscription GameObjectManager::subscribe(GameObject *obj, ChannelID channel)
     {
-	    std::map<ID,GameObject*>::iterator objIter;
+	    if (channel >= mChannels.size())
+	    {
+		    OGRE_EXCEPT(Ogre::Exception::ERR_ITEM_NOT_FOUND, "No channel with ID " 
+				    + Ogre::StringConverter::toString(channel) + "!", "NGF::GameObjectManager::subscribe()");
+	    }
+
+	    for (unsigned int i = 0; i < obj->mSubscriptions.size(); ++i)
+	    {
+		    unsigned int index = obj->mSubscriptions[i];
+		    if (mSubscriptionSlots[index].channel == channel)
+		    {
+			    return Subscription(index, mSubscriptionSlots[index].generation);
+		    }
+	    }
+
+	    unsigned int index;
+	    if (mFreeSubscriptions.empty())
+	    {
+		    index = mSubscriptionSlots.size();
+		    mSubscriptionSlots.push_back(SubscriptionSlot());
+	    }
+	    else
+	    {
+		    index = mFreeSubscriptions.back();
+		    mFreeSubscriptions.pop_back();
+	    }
+
+	    Channel *chan = mChannels[channel];
+	    SubscriptionSlot &slot = mSubscriptionSlots[index];
+	    slot.obj = obj;
+	    slot.channel = channel;
+	    slot.member = chan->members.size();
+
+	    chan->members.push_back(obj);
+	    chan->subscriptions.push_back(index);
+	    obj->mSubscriptions.push_back(index);
 
-	    for (objIter = mGameObjectMap.begin();
-			    objIter != mGameObjectMap.end(); ++objIter)
+	    return Subscription(index, slot.generation);
+    }
+    //----------------------------------------------------------------------------------
+    bool GameObjectManager::unsubscribe(const Subscription &sub)
+    {
+	    if (!isSubscribed(sub))
 	    {
-		    func(objIter->second);
+		    return false;
 	    }
+
+	    std::vector<unsigned int> &subs = mSubscriptionSlots[sub.index].obj->mSubscriptions;
+	    std::vector<unsigned int>::iterator iter = std::find(subs.begin(), subs.end(), sub.index);
+	    *iter = subs.back();
+	    subs.pop_back();
+
+	    _unsubscribe(sub.index);
+	    return true;
     }
     //----------------------------------------------------------------------------------
-    void GameObjectManager::sendMessage(GameObject *obj, Message msg) const
+    void GameObjectManager::_unsubscribe(unsigned int index)
     {
-	    if (obj)
+	    SubscriptionSlot &slot = mSubscriptionSlots[index];
+	    Channel *chan = mChannels[slot.channel];
+
+	    //Move the last subscriber into the gap.
+	    unsigned int last = chan->members.size() - 1;
+	    chan->members[slot.member] = chan->members[last];
+	    chan->subscriptions[slot.member] = chan->subscriptions[last];
+	    mSubscriptionSlots[chan->subscriptions[slot.member]].member = slot.member;
+	    chan->members.pop_back();
+	    chan->subscriptions.pop_back();
+
+	    slot.obj = 0;
+	    ++slot.generation;
+	    mFreeSubscriptions.push_back(index);
+    }
+    //----------------------------------------------------------------------------------
+    void GameObjectManager::_unsubscribeAll(GameObject *obj)
+    {
+	    for (unsigned int i = 0; i < obj->mSubscriptions.size(); ++i)
 	    {
-		    obj->receiveMessage(msg);
+		    _unsubscribe(obj->mSubscriptions[i]);
 	    }
+	    obj->mSubscriptions.clear();
     }
     //----------------------------------------------------------------------------------
-    GameObject* GameObjectManager::getByName(Ogre::String name)
+    void GameObjectManager::_partitionSubscriptions()
     {
-	    GameObject* findObj = NULL;
-	    std::map<ID,GameObject*>::iterator objIter;
-
-	    for (objIter = mGameObjectMap.begin();
-			    objIter != mGameObjectMap.end(); ++objIter)
+	    //Like _partitionIndices.
+	    std::vector<Channel*>::iterator iter;
+	    for (iter = mChannels.begin(); iter != mChannels.end(); ++iter)
 	    {
-		    GameObject *obj = objIter->second;
-		    if (obj->getName() == name)
+		    std::vector<GameObject*> &objs = (*iter)->members;
+		    std::vector<unsigned int> &subs = (*iter)->subscriptions;
+		    unsigned int j = 0;
+
+		    for (unsigned int i = 0; i < objs.size(); ++i)
 		    {
-			    findObj = obj;
-			    break;
+			    SubscriptionSlot &slot = mSubscriptionSlots[subs[i]];
+
+			    if (objs[i]->mManaged)
+			    {
+				    slot.member = j;
+				    objs[j] = objs[i];
+				    subs[j] = subs[i];
+				    ++j;
+			    }
+			    else
+			    {
+				    objs[i]->mSubscriptions.clear();
+				    slot.obj = 0;
+				    ++slot.generation;
+				    mFreeSubscriptions.push_back(subs[i]);
+			    }
 		    }
+
+		    objs.resize(j);
+		    subs.resize(j);
 	    }
+    }
+    //----------------------------------------------------------------------------------
+    GameObjectManager::ObjectRange GameObjectManager::getSubscribers(ChannelID channel) const
+    {
+	    const std::vector<GameObject*> &objs = channel < mChannels.size() ? mChannels[channel]->members : msNoMembers;
+	    return ObjectRange(objs.begin(), objs.end());
+    }
+    //----------------------------------------------------------------------------------
+    GameObjectManager::ObjectRange GameObjectManager::getSubscribers(const Ogre::String &channel) const
+    {
+	    boost::unordered_map<Ogre::String, ChannelID>::const_iterator iter = mChannelIDs.find(channel);
+	    return getSubscribers(iter == mChannelIDs.end() ? (ChannelID) mChannels.size() : iter->second);
+    }
+    //----------------------------------------------------------------------------------
+    GameObject* GameObjectManager::getByName(const Ogre::String &name) const
+    {
+	    NameMap::const_iterator nameIter = mNameMap.find(name);
 
-	    return findObj;
+	    return (nameIter == mNameMap.end()) ? NULL : nameIter->second;
     }
 
 /*
@@ -588,6 +4741,8 @@ namespace NGF {
         //----------------------------------------------------------------------------------
         void Loader::loadLevel(Ogre::String levelname, Ogre::Vector3 displace, Ogre::Quaternion rotate)
         {
+                NGF_PROFILE_LABEL(ProfileScope::NO_TYPE, PROFILE_LOAD, levelname);
+
                 //Get the script and its children (the objects).
                 ConfigNode *lvl = ConfigScriptLoader::getSingleton().getConfigScript("ngflevel", levelname);
 
@@ -599,6 +4754,11 @@ namespace NGF {
 
                 std::vector<ConfigNode*> objs = lvl->getChildren();
 
+                //With the factory, everything is created together at the end.
+                std::vector<ObjectSpawn> spawns;
+                if (mUseFactory)
+                        spawns.reserve(objs.size());
+
                 //Iterate through the children and do stuff.
                 for (std::vector<ConfigNode*>::iterator i = objs.begin(); i != objs.end(); ++i)
                 {
@@ -656,10 +4816,21 @@ namespace NGF {
 
                         //Call the callback function.
                         if (mUseFactory)
-                                mGameMgr->createObject(type, pos, rot, properties, name);
+                        {
+                                spawns.push_back(ObjectSpawn());
+                                ObjectSpawn &spawn = spawns.back();
+                                spawn.type = type;
+                                spawn.pos = pos;
+                                spawn.rot = rot;
+                                spawn.properties.swap(properties);
+                                spawn.name = name;
+                        }
                         else
                                 mHelper(type, name, pos, rot, properties);
                 }
+
+                if (mUseFactory)
+                        mGameMgr->createObjects(spawns);
         }
         //----------------------------------------------------------------------------------
         std::vector<Ogre::String> Loader::getLevels()
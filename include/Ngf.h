@@ -17,6 +17,9 @@
 
 #include <map>
 #include <vector>
+#include <bitset>
+#include <new>
+#include <iosfwd>
 
 #include "OgreSingleton.h"
 #include "OgreException.h"
@@ -26,6 +29,8 @@
 #include "OgreStringConverter.h"
 
 #include "boost/any.hpp"
+#include "boost/optional.hpp"
+#include "boost/unordered_map.hpp"
 
 #include "FastDelegate.h"
 
@@ -33,14 +38,18 @@
 //typename and a string. ;-)
 #define NGF_REGISTER_OBJECT_TYPE(type) NGF::GameObjectFactory::getSingleton().registerObjectType< class type >( #type )
 
+//Same, but with NGF::TypeOptions, like NGF_REGISTER_OBJECT_TYPE_WITH(Brush, NGF::TypeOptions().tick(NGF::TICK_NONE)).
+#define NGF_REGISTER_OBJECT_TYPE_WITH(type, options) \
+	NGF::GameObjectFactory::getSingleton().registerObjectType< class type >( #type, options )
+
 //Allows NGF_MESSAGE(MSG_SETTRANSFORM, Vector3(10,20,30), Quaternion(1,2,3,4))
 #define NGF_MESSAGE(name, ...) (NGF::Message( name ), ##__VA_ARGS__)
 
-//For consistency with 'NGF_NO_REPLY', because 'return boost::any(something)' looks different.
-#define NGF_SEND_REPLY return boost::any
+//For consistency with 'NGF_NO_REPLY', because 'return NGF::MessageReply(something)' looks different.
+#define NGF_SEND_REPLY return NGF::MessageReply
 
 //For 'void messages'.
-#define NGF_NO_REPLY() return boost::any()
+#define NGF_NO_REPLY() return NGF::MessageReply()
 
 namespace NGF {
 
@@ -75,22 +84,243 @@ public:
 	static PropertyList create(Ogre::String key, Ogre::String values, Ogre::String delims = " ");
 };
 
+/*
+ * =====================================================================================
+ *        Class: MessageRegistry
+ *  Description: Gives message names codes, so a Message made with a name can be
+ *               told apart by its code. Names are given codes from 
+ *               NGF_MSG_INTERNED_BASE up the first time they're seen, unless they
+ *               were given one with 'registerName'. To 'switch' on messages, give 
+ *               them codes of your own (below NGF_MSG_INTERNED_BASE) like so:
+ *
+ *                   enum { MSG_SET_TRANSFORM = 1 };
+ *                   NGF::MessageRegistry::registerName("setTransform", MSG_SET_TRANSFORM);
+ *
+ *               after which Message("setTransform") has code MSG_SET_TRANSFORM, for
+ *               scripts too. Like the flag registry it's locked, so Messages can be
+ *               made by name from parallel ticks. Keeping the code of a busy name
+ *               (see NGF_MSG) saves the lock.
+ * =====================================================================================
+ */
+
+#define NGF_MSG_INTERNED_BASE (1u << 30)
+
+//The code of a message name. Keep it if you use it a lot.
+#define NGF_MSG(name) (NGF::MessageRegistry::getCode(name))
+
+class MessageRegistry
+{
+public:
+	//Get the code for the name, giving it one if needed. "" has code 0.
+	static unsigned int getCode(const Ogre::String &name);
+
+	//Get the code for the name if it has one. Returns whether it did.
+	static bool findCode(const Ogre::String &name, unsigned int &code);
+
+	//Get the name for a code, or "" if there's none.
+	static const Ogre::String &getName(unsigned int code);
+
+	//Give a name the given code. Do this before the name is used in any Message. Throws
+	//if the name or code is already taken by something else.
+	static void registerName(const Ogre::String &name, unsigned int code);
+
+	//Get a new code for a TypedMessage.
+	static unsigned int _newTypedCode();
+};
+
+/*
+ * =====================================================================================
+ *        Class: MessageParam
+ *  Description: One parameter of a Message. Reals, ints, bools, Vector3s, 
+ *               Quaternions and GameObject pointers are kept inline, anything else 
+ *               copy-constructible is kept in a boost::any. Like boost::any, you get
+ *               the value back with exactly the type it was given with, else
+ *               boost::bad_any_cast is thrown (or, with 'find', nothing is found).
+ *               Replies to messages are MessageParams too.
+ * =====================================================================================
+ */
+
+class GameObject;
+
+class MessageParam
+{
+	enum Type
+	{
+		PARAM_NONE,
+		PARAM_FLOAT,
+		PARAM_DOUBLE,
+		PARAM_INT,
+		PARAM_UINT,
+		PARAM_BOOL,
+		PARAM_VECTOR3,
+		PARAM_QUATERNION,
+		PARAM_OBJECT,
+		PARAM_ANY
+	};
+
+	Type mType;
+	union
+	{
+		Ogre::Real r[4];
+		float f;
+		double d;
+		int i;
+		unsigned int u;
+		bool b;
+		GameObject *obj;
+		boost::any *any;
+	} mData;
+
+	void _clear() { if (mType == PARAM_ANY) delete mData.any; mType = PARAM_NONE; }
+
+	void _store(float val) { mType = PARAM_FLOAT; mData.f = val; }
+	void _store(double val) { mType = PARAM_DOUBLE; mData.d = val; }
+	void _store(int val) { mType = PARAM_INT; mData.i = val; }
+	void _store(unsigned int val) { mType = PARAM_UINT; mData.u = val; }
+	void _store(bool val) { mType = PARAM_BOOL; mData.b = val; }
+	void _store(GameObject *val) { mType = PARAM_OBJECT; mData.obj = val; }
+	void _store(const Ogre::Vector3 &val) 
+	{ mType = PARAM_VECTOR3; mData.r[0] = val.x; mData.r[1] = val.y; mData.r[2] = val.z; }
+	void _store(const Ogre::Quaternion &val) 
+	{ mType = PARAM_QUATERNION; mData.r[0] = val.w; mData.r[1] = val.x; mData.r[2] = val.y; mData.r[3] = val.z; }
+	void _store(const boost::any &val) { mType = PARAM_ANY; mData.any = new boost::any(val); }
+	void _store(const char *val) { mType = PARAM_ANY; mData.any = new boost::any(val); }
+	template<typename T>
+	void _store(const T &val) { mType = PARAM_ANY; mData.any = new boost::any(val); }
+
+	//Find the value as the type pointed to. Kept in a boost::any (say, if it was given
+	//as one), the usual types are found too.
+	boost::optional<float> _find(float*) const 
+	{ return mType == PARAM_FLOAT ? boost::optional<float>(mData.f) : _findAny<float>(); }
+	boost::optional<double> _find(double*) const 
+	{ return mType == PARAM_DOUBLE ? boost::optional<double>(mData.d) : _findAny<double>(); }
+	boost::optional<int> _find(int*) const 
+	{ return mType == PARAM_INT ? boost::optional<int>(mData.i) : _findAny<int>(); }
+	boost::optional<unsigned int> _find(unsigned int*) const 
+	{ return mType == PARAM_UINT ? boost::optional<unsigned int>(mData.u) : _findAny<unsigned int>(); }
+	boost::optional<bool> _find(bool*) const 
+	{ return mType == PARAM_BOOL ? boost::optional<bool>(mData.b) : _findAny<bool>(); }
+	boost::optional<GameObject*> _find(GameObject**) const 
+	{ return mType == PARAM_OBJECT ? boost::optional<GameObject*>(mData.obj) : _findAny<GameObject*>(); }
+	boost::optional<Ogre::Vector3> _find(Ogre::Vector3*) const 
+	{ 
+		return mType == PARAM_VECTOR3 ? boost::optional<Ogre::Vector3>(Ogre::Vector3(mData.r[0], mData.r[1], mData.r[2]))
+			: _findAny<Ogre::Vector3>(); 
+	}
+	boost::optional<Ogre::Quaternion> _find(Ogre::Quaternion*) const 
+	{ 
+		return mType == PARAM_QUATERNION 
+			? boost::optional<Ogre::Quaternion>(Ogre::Quaternion(mData.r[0], mData.r[1], mData.r[2], mData.r[3])) 
+			: _findAny<Ogre::Quaternion>(); 
+	}
+	boost::optional<boost::any> _find(boost::any*) const { return boost::optional<boost::any>(toAny()); }
+	template<typename T>
+	boost::optional<T> _find(T*) const { return _findAny<T>(); }
+
+	template<typename T>
+	boost::optional<T> _findAny() const
+	{
+		const T *val = mType == PARAM_ANY ? boost::any_cast<T>(mData.any) : 0;
+		return val ? boost::optional<T>(*val) : boost::optional<T>();
+	}
+
+public:
+	MessageParam() : mType(PARAM_NONE) { }
+	template<typename T>
+	MessageParam(const T &val) : mType(PARAM_NONE) { _store(val); }
+	MessageParam(const MessageParam &other) : mType(PARAM_NONE) { *this = other; }
+	~MessageParam() { _clear(); }
+
+	MessageParam &operator=(const MessageParam &other)
+	{
+		if (this != &other)
+		{
+			_clear();
+			mType = other.mType;
+			mData = other.mData;
+			if (mType == PARAM_ANY)
+				mData.any = new boost::any(*other.mData.any);
+		}
+		return *this;
+	}
+
+	//Get the value. T must be the type it was given with.
+	template<typename T> T get() const 
+	{ 
+		boost::optional<T> val = _find((T *) 0); 
+		if (!val) 
+			throw boost::bad_any_cast(); 
+		return *val; 
+	}
+
+	//Get the value if it is of type T, without throwing.
+	template<typename T> boost::optional<T> find() const { return _find((T *) 0); }
+
+	//Whether there's no value.
+	bool empty() const { return mType == PARAM_NONE; }
+
+	//The value as a boost::any. MessageParams are made from boost::anys and turn back
+	//into them, so code that kept replies as boost::anys (MessageReply used to be one)
+	//works as before, like boost::any_cast<int>(reply).
+	boost::any toAny() const;
+	operator boost::any() const { return toAny(); }
+};
+
+/*
+ * =====================================================================================
+ *        Class: MessageParams
+ *  Description: The parameters of a Message. The first few are kept inline.
+ * =====================================================================================
+ */
+
+class MessageParams
+{
+	enum { NUM_INLINE = 4 };
+
+	MessageParam mInline[NUM_INLINE];
+	std::vector<MessageParam> mMore;
+	unsigned int mSize;
+
+public:
+	MessageParams() : mSize(0) { }
+
+	unsigned int size() const { return mSize; }
+	bool empty() const { return mSize == 0; }
+	void clear() { for (unsigned int i = 0; i < NUM_INLINE; ++i) mInline[i] = MessageParam(); mMore.clear(); mSize = 0; }
+
+	void push_back(const MessageParam &param)
+	{
+		if (mSize < NUM_INLINE)
+			mInline[mSize] = param;
+		else
+			mMore.push_back(param);
+		++mSize;
+	}
+
+	MessageParam &operator[](unsigned int index) 
+	{ return index < NUM_INLINE ? mInline[index] : mMore[index - NUM_INLINE]; }
+	const MessageParam &operator[](unsigned int index) const
+	{ return index < NUM_INLINE ? mInline[index] : mMore[index - NUM_INLINE]; }
+};
+
 /*
  * =====================================================================================
  *       Struct: Message
  *  Description: This struct represents the Messages that are sent between the
- *               GameObjects. It uses the MessageParams typedef, which allows you to
- *               send any number of copy-constructible (Vector3, Quaternion etc) objects
- *		 in a message. This requres boost.
+ *               GameObjects. It uses MessageParams, which allows you to send any
+ *               number of copy-constructible (Vector3, Quaternion etc) objects in a 
+ *               message. The usual ones don't need any memory allocated. Messages 
+ *               are passed around by const reference.
  *
  *		 Messages also have an unsigned 'code' field so you can use them with
  *		 enums and 'switch'. It is recommended to use '0' as a 'no code' field, 
- *		 because that's the default in case no code is given.
+ *		 because that's the default in case no code is given. Messages made with
+ *		 a name get that name's code (see MessageRegistry). They keep a copy of
+ *		 the name too, for receivers that look at it, which can allocate. For
+ *		 messages sent a lot, give the code (see NGF_MSG) instead.
  * =====================================================================================
  */
 
-typedef std::vector<boost::any> MessageParams;
-
 struct Message
 {
 	Ogre::String name;
@@ -99,17 +329,88 @@ struct Message
 
 	//Create a Message with the given name or code and parameters.
 	
-	Message(Ogre::String nm, MessageParams parameters = MessageParams())
-	    : name(nm), code(0), params(parameters) { }
-	Message(unsigned int cod, MessageParams parameters = MessageParams())
-	    : name(""), code(cod), params(parameters) { }
+	Message(const Ogre::String &nm, const MessageParams &parameters = MessageParams())
+	    : name(nm), code(MessageRegistry::getCode(nm)), params(parameters) { }
+	Message(unsigned int cod, const MessageParams &parameters = MessageParams())
+	    : code(cod), params(parameters) { }
 
 	//These methods allow you to get the name, code and parameters respectively.
-	template<typename T> T getParam(int index) { return boost::any_cast<T>(params[index]); }
+	template<typename T> T getParam(int index) const { return params[index].get<T>(); }
 
 	//So you can do:
 	// gom->sendMessage(obj, (NGF::Message("printStuff"), Vector3(10,20,30), Quaternion(1,2,3,4)));
-	template<typename T> Message& operator,(T thing) { params.push_back(boost::any(thing)); return *this; }
+	template<typename T> Message& operator,(const T &thing) { params.push_back(MessageParam(thing)); return *this; }
+};
+
+/*
+ * =====================================================================================
+ *       Struct: TypedMessage
+ *  Description: Messages can also be structs of their own, derived from TypedMessage
+ *               of themselves:
+ *
+ *                   struct MsgSetTransform : public NGF::TypedMessage<MsgSetTransform>
+ *                   {
+ *                       Ogre::Vector3 pos;
+ *                       Ogre::Quaternion rot;
+ *
+ *                       MsgSetTransform(const Ogre::Vector3 &p, const Ogre::Quaternion &r)
+ *                           : pos(p), rot(r) { }
+ *                   };
+ *
+ *                   gom->sendMessage(obj, MsgSetTransform(pos, rot));
+ *
+ *               They go straight to the handler the GameObject's type has for them (see
+ *               MessageTable), with nothing to look up by name or cast. Each gets a code
+ *               of its own, from NGF_MSG_TYPED_BASE up. GameObjects with no handler for
+ *               one get a Message with that code, and the struct as its only parameter.
+ * =====================================================================================
+ */
+
+#define NGF_MSG_TYPED_BASE (1u << 31)
+
+template<typename M>
+struct TypedMessage
+{
+	//The code of messages of this type. Like flags, don't use it for the first time in
+	//parallel ticks.
+	static unsigned int getCode() { static unsigned int code = MessageRegistry::_newTypedCode(); return code; }
+};
+
+/*
+ * =====================================================================================
+ *        Class: FlagRegistry
+ *  Description: GameObject flags are given as strings, but each name is given a small
+ *               number the first time it is seen, and GameObjects keep a bitset of
+ *               these. Flags that are used a lot can be looked up once and kept, so
+ *               that checking them doesn't need the string at all.
+ *
+ *               The registry is locked, so flags can be looked up and made from
+ *               parallel ticks too. Keeping the FlagIDs of busy flags saves the lock.
+ * =====================================================================================
+ */
+
+//The most flags there can be.
+#ifndef NGF_MAX_FLAGS
+#define NGF_MAX_FLAGS 64
+#endif
+
+typedef unsigned int FlagID;
+typedef std::bitset<NGF_MAX_FLAGS> FlagSet;
+
+class FlagRegistry
+{
+public:
+	//Get the FlagID for the name, making it if needed.
+	static FlagID getFlag(const Ogre::String &name);
+
+	//Get the FlagID for the name if it exists. Returns whether it did.
+	static bool findFlag(const Ogre::String &name, FlagID &flag);
+
+	//Get the name of a flag.
+	static const Ogre::String &getFlagName(FlagID flag);
+
+	//Get the number of flags made so far.
+	static unsigned int getNumFlags();
 };
 
 /*
@@ -124,18 +425,104 @@ struct Message
 //Each GameObject has a unique ID.
 typedef unsigned int ID;
 
-//So users don't have to know about boost.
-typedef boost::any MessageReply;
+//An ID is made of a slot index (the lower NGF_ID_INDEX_BITS bits) and the generation of that
+//slot (the NGF_ID_GENERATION_BITS bits above it). The generation is bumped every time a slot is
+//freed, so an ID kept around after its GameObject is destroyed doesn't refer to whatever
+//GameObject reuses the slot. The top bit is left alone so IDs stay positive as ints (Python etc.).
+#define NGF_ID_INDEX_BITS 20
+#define NGF_ID_GENERATION_BITS 11
+
+//Replies are kept like message parameters, so the usual ones need no memory allocated.
+typedef MessageParam MessageReply;
+
+//What became of a message sent with GameObjectManager::trySendMessageWithReply.
+enum ReplyStatus
+{
+	REPLY_OK,
+	REPLY_NO_OBJECT,	//There was no GameObject to send it to.
+	REPLY_NONE,		//The GameObject didn't reply.
+	REPLY_BAD_TYPE,		//The GameObject replied with something of another type.
+	REPLY_IN_PARALLEL,	//It was sent from a parallel tick, which can't wait for replies.
+
+	//For requests (see GameObjectManager::requestReply).
+	REPLY_PENDING,		//The reply hasn't come yet.
+	REPLY_DROPPED,		//The message queue was full.
+	REPLY_UNKNOWN		//There's no such request (it was released).
+};
+
+//The reply to a message sent with GameObjectManager::trySendMessageWithReply. Holds the 
+//value if the status is REPLY_OK.
+template<typename T>
+struct Reply
+{
+	ReplyStatus status;
+	boost::optional<T> value;
+
+	//A reply holding 'val'.
+	Reply(const T &val) : status(REPLY_OK), value(val) { }
+
+	//A reply without a value, with the status saying why. Not a constructor, as it would
+	//be ambiguous with the one above for Reply<int> or Reply<ReplyStatus>.
+	static Reply failed(ReplyStatus stat) { Reply reply; reply.status = stat; return reply; }
+
+	//Whether there is a value.
+	bool ok() const { return status == REPLY_OK; }
+
+	//Get the value. There must be one.
+	const T &get() const { return *value; }
+
+	//Get the value, or 'other' if there is none.
+	T getOr(const T &other) const { return value ? *value : other; }
+
+private:
+	Reply() : status(REPLY_NONE) { }
+};
+
+//Which ticks a GameObject gets. OR them together.
+enum TickFlags
+{
+	TICK_NONE = 0,
+	TICK_UNPAUSED = 1 << 0,
+	TICK_PAUSED = 1 << 1,
+	TICK_ALL = TICK_UNPAUSED | TICK_PAUSED,
+
+	//'interpolatedTick' once a frame (see GameObjectManager::setFixedTimeStep). Not
+	//part of TICK_ALL, ask for it explicitly.
+	TICK_INTERPOLATE = 1 << 2,
+
+	//Whatever the GameObject's type was registered with (see TypeOptions).
+	TICK_DEFAULT = 1 << 16
+};
 
 class GameObject
 {
 	ID mID;
 	Ogre::String mType;
-	Ogre::String mFlags;
+	FlagSet mFlags;
 	Ogre::String mName;
         bool mPersistent;
 
+	//Bookkeeping for the GameObjectManager.
+	bool mManaged;
+	bool mPooled;
+	unsigned int mTypeIndex;
+	unsigned int mTickFlags;
+	unsigned int mTickInterval;
+	signed char mTickDeferrable;	//-1 for whatever the type's is.
+	int mTickPriority;
+	unsigned int mTickGroups[3];
+	unsigned int mTickBuckets[3];
+	unsigned int mTickIndices[3];
+	unsigned int mTypeMemberIndex;
+	std::vector<std::pair<FlagID, unsigned int> > mFlagIndices;
+	unsigned int mTransformIndex;
+	std::vector<unsigned int> mSubscriptions;
+	unsigned int mFirstTask;
+
 	friend class GameObjectManager;
+	friend class SpatialIndex;
+	friend class TaskWheel;
+	friend class ProfileScope;
 
 protected:
 	PropertyList mProperties;
@@ -149,12 +536,21 @@ public:
 	      mName(name),
 	      mProperties(properties),
 	      mType("NGF::GameObject"),
-              mPersistent(false)
+              mPersistent(false),
+	      mManaged(false),
+	      mPooled(false),
+	      mTypeIndex(0),
+	      mTickFlags(TICK_DEFAULT),
+	      mTickInterval(0),
+	      mTickDeferrable(-1),
+	      mTickPriority(0),
+	      mTransformIndex(~0u),
+	      mFirstTask(~0u)
 	{
 	}
 
 	//Called on destruction.
-	virtual ~GameObject() { }
+	virtual ~GameObject();
 
 	//Called every unpaused frame.
 	virtual void unpausedTick(const Ogre::FrameEvent& evt ) { }
@@ -162,12 +558,29 @@ public:
 	//Called every paused frame.
 	virtual void pausedTick(const Ogre::FrameEvent& evt) { }
 
+	//Called once every unpaused frame after the unpaused ticks, if the GameObject asked for
+	//TICK_INTERPOLATE. 'alpha' is how far (0 to 1) the frame is between the last fixed step
+	//and the next, for placing things to be rendered. It's 1 with no fixed time step.
+	virtual void interpolatedTick(const Ogre::FrameEvent& evt, Ogre::Real alpha) { }
+
 	//Called when a message is received.
-	virtual MessageReply receiveMessage(Message msg) { NGF_NO_REPLY(); }
+	virtual MessageReply receiveMessage(const Message &msg) { NGF_NO_REPLY(); }
 
 	//Called on destruction (for scripted objects, as they are GCed).
 	virtual void destroy(void) { }
 
+	//For types registered with TypeOptions().recycle(). Called instead of destruction when
+	//the GameObject is destroyed and kept to be used again. Hide things, stop sounds etc.
+	virtual void deactivate(void) { }
+
+	//For types registered with TypeOptions().recycle(). Called instead of construction
+	//when a kept GameObject is used for a new one. The ID, name and properties are already
+	//set. The tick flags are kept from its last life. Its flags are cleared, it isn't
+	//persistent, and its tick interval and deferral are its type's again, so set any of
+	//those the constructor sets here too. Like in the constructor, all of them can be set
+	//here.
+	virtual void reactivate(Ogre::Vector3 pos, Ogre::Quaternion rot, PropertyList properties) { }
+
 	//------ Called by other objects, and not overridden ------
 
 	//Returns the ID of the  GameObject.
@@ -180,22 +593,429 @@ public:
 	PropertyList getProperties(void) const { return mProperties; }
 
 	//Adds a flag to the GameObject's flags.
-	GameObject* addFlag(Ogre::String flag);
+	GameObject* addFlag(const Ogre::String &flag) { return addFlag(FlagRegistry::getFlag(flag)); }
+	GameObject* addFlag(FlagID flag);
 
 	//Removes a flag from the GameObject's flags. Returns whether it was found.
-	bool removeFlag(Ogre::String flag);
+	bool removeFlag(const Ogre::String &flag);
+	bool removeFlag(FlagID flag);
 
 	//Checks whether the GameObject has a flag.
-	bool hasFlag(Ogre::String flag) const;
+	bool hasFlag(const Ogre::String &flag) const;
+	bool hasFlag(FlagID flag) const { return mFlags.test(flag); }
 
-	//Returns the flags string.
-	Ogre::String getFlags() const { return mFlags; }
+	//Returns the flags as a string, like "|flag1|flag2|" (or "" if there are none).
+	Ogre::String getFlags() const;
+
+	//Returns the flags as a FlagSet.
+	const FlagSet &getFlagSet() const { return mFlags; }
 
         //Set persistent (not destroyed when you call 'destroyAll').
         void setPersistent(bool persistent) { mPersistent = persistent; }
 
         //Check whether persistent.
         bool isPersistent() { return mPersistent; }
+
+	//Set which ticks this GameObject gets (TickFlags ORed together). Only GameObjects that
+	//ask for a tick are visited by GameObjectManager::tick. Can be called in the constructor.
+	void setTickFlags(unsigned int flags);
+
+	//Get which ticks this GameObject gets.
+	unsigned int getTickFlags() const { return mTickFlags; }
+
+	//Tick this GameObject only every 'frames' frames, with the time since its last tick
+	//in the FrameEvent. 0 means whatever its type was registered with (see TypeOptions).
+	//Can be called in the constructor.
+	void setTickInterval(unsigned int frames);
+
+	//Get the tick interval given with setTickInterval (0 if the type's is used).
+	unsigned int getTickInterval() const { return mTickInterval; }
+
+	//Let the unpaused tick of this GameObject be put off to a later frame when the tick
+	//budget is used up (see GameObjectManager::setTickBudget), with higher priorities
+	//ticking first. Until this is called it's as its type was registered (see 
+	//TypeOptions::deferrable). A deferrable unpaused tick comes after the tick phases,
+	//on the main thread and ignoring the tick interval, whatever the type's options. Can
+	//be called in the constructor.
+	void setDeferrableTick(bool deferrable, int priority = 0);
+
+	//Whether the unpaused tick can be put off, and its priority. Once created, the type's
+	//are given if setDeferrableTick wasn't called.
+	bool isTickDeferrable() const;
+	int getTickPriority() const;
+};
+
+/*
+ * =====================================================================================
+ *        Class: TypeOptions
+ *  Description: Options for a GameObject type, given when it is registered. Chain the
+ *               methods like so: TypeOptions().tick(TICK_UNPAUSED).
+ * =====================================================================================
+ */
+
+class TypeOptions
+{
+public:
+	unsigned int tickFlags;
+	bool parallelTick;
+	Ogre::String tickPhase;
+	unsigned int tickInterval;
+	unsigned int poolSlabSize;
+	unsigned int recycleCount;
+	bool hasTransform;
+	bool deferrableTick;
+	int tickPriority;
+
+	TypeOptions()
+	    : tickFlags(TICK_ALL),
+	      parallelTick(false),
+	      tickPhase("Default"),
+	      tickInterval(1),
+	      poolSlabSize(0),
+	      recycleCount(0),
+	      hasTransform(false),
+	      deferrableTick(false),
+	      tickPriority(0)
+	{
+	}
+
+	//Which ticks GameObjects of this type get by default (TickFlags ORed together).
+	//Types that do nothing per-frame should give TICK_NONE.
+	TypeOptions & tick(unsigned int flags) { tickFlags = flags; return *this; }
+
+	//Whether 'unpausedTick' of this type can run on a worker thread at the same time as
+	//other parallel ticks (see GameObjectManager::setTickThreads). Such a tick may read
+	//other GameObjects but must only change things through createObject, destroyObject,
+	//requestDestroy and sendMessage, which are recorded and done after the parallel part.
+	//No sendMessageWithReply, no Python.
+	TypeOptions & parallel(bool par = true) { parallelTick = par; return *this; }
+
+	//The tick phase GameObjects of this type tick in (see GameObjectManager::addTickPhase).
+	TypeOptions & phase(const Ogre::String &name) { tickPhase = name; return *this; }
+
+	//Tick GameObjects of this type only every 'frames' frames. They are spread over the
+	//frames evenly, and each gets the time since its last tick in the FrameEvent.
+	TypeOptions & interval(unsigned int frames) { tickInterval = frames; return *this; }
+
+	//Make GameObjects of this type in a pool instead of with 'new', for types that are 
+	//created and destroyed a lot. The pool grows by slabs of 'objectsPerSlab' GameObjects
+	//laid out one after another, and destroyed GameObjects leave their place free for the
+	//next one. 0 means no pool.
+	TypeOptions & pool(unsigned int objectsPerSlab = 256) { poolSlabSize = objectsPerSlab; return *this; }
+
+	//Keep up to 'maxKept' destroyed GameObjects of this type to be used again by later 
+	//creations, instead of destructing and constructing them (see GameObject::deactivate
+	//and GameObject::reactivate). 0 means none are kept.
+	TypeOptions & recycle(unsigned int maxKept = 64) { recycleCount = maxKept; return *this; }
+
+	//Give GameObjects of this type a transform (see GameObjectManager::setTransform) when
+	//they are created, at the position and rotation they are created with.
+	TypeOptions & transform(bool has = true) { hasTransform = has; return *this; }
+
+	//Let the unpaused ticks of GameObjects of this type be put off to a later frame when
+	//the tick budget is used up (see GameObjectManager::setTickBudget), with higher 
+	//priorities ticking first. Deferrable unpaused ticks come after all the tick phases
+	//and ignore the tick interval, which (like the phase) only applies to the paused
+	//ticks then. They can't be parallel, setTypeOptions throws if asked for both.
+	TypeOptions & deferrable(int priority = 0) { deferrableTick = true; tickPriority = priority; return *this; }
+};
+
+//How much of a type's pool (see TypeOptions::pool) is used.
+struct PoolStats
+{
+	unsigned int numSlabs;
+	unsigned int capacity;
+	unsigned int numUsed;
+	unsigned int peakUsed;
+
+	PoolStats() : numSlabs(0), capacity(0), numUsed(0), peakUsed(0) { }
+};
+
+//What happened to posted messages (see GameObjectManager::postMessage) in a frame.
+struct MessageQueueStats
+{
+	unsigned int numPosted;
+	unsigned int numDelivered;
+	unsigned int numDropped;	//Posted while the queue was full.
+	unsigned int numStale;		//Their GameObject was gone by delivery.
+	unsigned int numDeliveries;	//Deliveries with something to deliver.
+	unsigned int peakQueued;
+
+	MessageQueueStats() 
+	    : numPosted(0), numDelivered(0), numDropped(0), numStale(0), numDeliveries(0), peakQueued(0) { }
+};
+
+//What the tick budget (see GameObjectManager::setTickBudget) did, in a frame or in total.
+struct TickBudgetStats
+{
+	unsigned int numFrames;
+	unsigned int numFramesDeferred;	//Frames that put off some ticks.
+	unsigned int numTicked;		//Deferrable ticks done.
+	unsigned int numDeferred;	//Deferrable ticks put off.
+	Ogre::Real longestWait;		//The most time a deferrable tick was for, in seconds.
+
+	TickBudgetStats() 
+	    : numFrames(0), numFramesDeferred(0), numTicked(0), numDeferred(0), longestWait(0) { }
+};
+
+//What the profiler times (see GameObjectManager::setProfiling).
+enum ProfileCategory
+{
+	PROFILE_TICK,
+	PROFILE_MESSAGE,
+	PROFILE_CREATE,
+	PROFILE_DESTROY,
+	PROFILE_PYTHON,		//Python events and methods of PythonGameObjects.
+	PROFILE_LOAD,		//Loading levels.
+
+	NUM_PROFILE_CATEGORIES
+};
+
+//What the profiler saw of a GameObject type since it was last reset. Ticks count each
+//GameObject ticked. Allocations are of new GameObjects, recycled ones aren't counted.
+struct ProfileStats
+{
+	unsigned int calls[NUM_PROFILE_CATEGORIES];
+	double time[NUM_PROFILE_CATEGORIES];	//In seconds.
+	unsigned int allocations;
+	unsigned int pooledAllocations;		//Of the allocations, those from the type's pool.
+	size_t allocatedBytes;
+
+	ProfileStats() : allocations(0), pooledAllocations(0), allocatedBytes(0)
+	{
+		for (unsigned int i = 0; i < NUM_PROFILE_CATEGORIES; ++i)
+		{
+			calls[i] = 0;
+			time[i] = 0;
+		}
+	}
+};
+
+/*
+ * =====================================================================================
+ *        Class: ProfileScope
+ *  Description: Times the code from where it's made to the end of its scope for the
+ *               profiler, as calls of a GameObject's type or of no type. Used through
+ *               the NGF_PROFILE_* macros, which are empty unless NGF_ENABLE_PROFILER is
+ *               defined. When the profiler is off it only checks a flag.
+ * =====================================================================================
+ */
+
+class ProfileScope
+{
+	unsigned int mTypeIndex;
+	ProfileCategory mCategory;
+	const char *mLabel;
+	double mStart;		//Negative if the profiler was off.
+
+	static bool msEnabled;
+
+	void _end();
+
+	friend class GameObjectManager;
+
+public:
+	static const unsigned int NO_TYPE = ~0u;
+
+	//How many calls the time is for. Nothing is recorded for none.
+	unsigned int calls;
+
+	//The label, if any, names the call in traces. It must stay around, like a literal.
+	ProfileScope(const GameObject *obj, ProfileCategory category, const char *label = 0)
+	    : mTypeIndex(obj ? obj->mTypeIndex : NO_TYPE), mCategory(category), mLabel(label),
+	      mStart(msEnabled ? _now() : -1), calls(1) { }
+	ProfileScope(unsigned int typeIndex, ProfileCategory category, const char *label = 0)
+	    : mTypeIndex(typeIndex), mCategory(category), mLabel(label), 
+	      mStart(msEnabled ? _now() : -1), calls(1) { }
+
+	//A copy of the label is kept.
+	ProfileScope(const GameObject *obj, ProfileCategory category, const Ogre::String &label)
+	    : mTypeIndex(obj ? obj->mTypeIndex : NO_TYPE), mCategory(category), 
+	      mLabel(msEnabled ? _intern(label) : 0), mStart(msEnabled ? _now() : -1), calls(1) { }
+	ProfileScope(unsigned int typeIndex, ProfileCategory category, const Ogre::String &label)
+	    : mTypeIndex(typeIndex), mCategory(category), 
+	      mLabel(msEnabled ? _intern(label) : 0), mStart(msEnabled ? _now() : -1), calls(1) { }
+
+	~ProfileScope() { if (mStart >= 0 && calls) _end(); }
+
+	static bool isEnabled() { return msEnabled; }
+
+	//--- Internal stuff --------------------------------------------------------------
+
+	//Seconds since the program started.
+	static double _now();
+
+	//Record 'calls' calls that took from 'start' to 'end'. 'thread' is the tick worker
+	//that made them, the main thread being worker 0.
+	static void _record(unsigned int typeIndex, ProfileCategory category, const char *label, 
+		double start, double end, unsigned int calls, unsigned int thread = 0);
+
+	//Record a new GameObject taking 'size' bytes.
+	static void _allocation(unsigned int typeIndex, size_t size, bool pooled);
+
+	//A copy of a label that stays around.
+	static const char *_intern(const Ogre::String &label);
+};
+
+#ifdef NGF_ENABLE_PROFILER
+#define NGF_PROFILE(obj, category) NGF::ProfileScope NGF_profileScope((obj), (category))
+#define NGF_PROFILE_LABEL(obj, category, label) NGF::ProfileScope NGF_profileScope((obj), (category), (label))
+#define NGF_PROFILE_CALLS(n) NGF_profileScope.calls = (n)
+#define NGF_PROFILE_ALLOCATION(typeIndex, size, pooled) NGF::ProfileScope::_allocation((typeIndex), (size), (pooled))
+#else
+#define NGF_PROFILE(obj, category)
+#define NGF_PROFILE_LABEL(obj, category, label)
+#define NGF_PROFILE_CALLS(n)
+#define NGF_PROFILE_ALLOCATION(typeIndex, size, pooled)
+#endif
+
+//An event channel (see GameObjectManager::getChannel).
+typedef unsigned int ChannelID;
+
+//A handle to a GameObject's subscription to an event channel (see GameObjectManager::subscribe).
+struct Subscription
+{
+	unsigned int index;
+	unsigned int generation;
+
+	Subscription(unsigned int idx = ~0u, unsigned int gen = 0) : index(idx), generation(gen) { }
+};
+
+//A handle to a request for a reply (see GameObjectManager::requestReply).
+struct RequestTicket
+{
+	unsigned int index;
+	unsigned int generation;
+
+	RequestTicket(unsigned int idx = ~0u, unsigned int gen = 0) : index(idx), generation(gen) { }
+};
+
+//Called with the reply to a request: the ticket, what became of the request, and the reply.
+typedef fastdelegate::FastDelegate3<RequestTicket, ReplyStatus, const MessageReply&> ReplyFunction;
+
+//A handle to a scheduled task (see GameObjectManager::scheduleTask).
+struct TaskHandle
+{
+	unsigned int index;
+	unsigned int generation;
+
+	TaskHandle(unsigned int idx = ~0u, unsigned int gen = 0) : index(idx), generation(gen) { }
+};
+
+//Called when a task is due, with its handle.
+typedef fastdelegate::FastDelegate1<TaskHandle> TaskFunction;
+
+//A GameObject to be created by GameObjectManager::createObjects.
+struct ObjectSpawn
+{
+	Ogre::String type;
+	Ogre::Vector3 pos;
+	Ogre::Quaternion rot;
+	PropertyList properties;
+	Ogre::String name;
+
+	ObjectSpawn() { }
+	ObjectSpawn(const Ogre::String &typ, const Ogre::Vector3 &position, const Ogre::Quaternion &rotation, 
+		const PropertyList &props = PropertyList(), const Ogre::String &nm = "")
+	    : type(typ), pos(position), rot(rotation), properties(props), name(nm) { }
+};
+
+/*
+ * =====================================================================================
+ *        Class: MessageHandler
+ *  Description: A message handler of a GameObject type (see MessageTable). 
+ * =====================================================================================
+ */
+
+class MessageHandler
+{
+public:
+	virtual ~MessageHandler() { }
+
+	//Handle a Message.
+	virtual MessageReply handle(GameObject *obj, const Message &msg) const = 0;
+
+	//Handle a TypedMessage, given a pointer to the struct. Only for handlers of TypedMessages.
+	virtual MessageReply handleTyped(GameObject *obj, const void *msg) const { NGF_NO_REPLY(); }
+};
+
+//Calls a handler, giving what it returns as the reply.
+template<typename R>
+struct _MessageCall
+{
+	template<typename C, typename M>
+	static MessageReply call(C *obj, R (C::*func)(const M&), const M &msg) { return (obj->*func)(msg); }
+};
+
+template<>
+struct _MessageCall<void>
+{
+	template<typename C, typename M>
+	static MessageReply call(C *obj, void (C::*func)(const M&), const M &msg) { (obj->*func)(msg); NGF_NO_REPLY(); }
+};
+
+//Handles TypedMessage M with a member function of C, for GameObjects of type T.
+template<typename T, typename C, typename M, typename R>
+class TypedMessageHandler : public MessageHandler
+{
+	R (C::*mFunc)(const M&);
+
+public:
+	TypedMessageHandler(R (C::*func)(const M&)) : mFunc(func) { }
+
+	MessageReply handle(GameObject *obj, const Message &msg) const 
+	{ M typed = msg.getParam<M>(0); return handleTyped(obj, &typed); }
+
+	MessageReply handleTyped(GameObject *obj, const void *msg) const
+	{ return _MessageCall<R>::call(static_cast<C*>(static_cast<T*>(obj)), mFunc, *static_cast<const M*>(msg)); }
+};
+
+//Handles Messages with a member function of C, for GameObjects of type T.
+template<typename T, typename C, typename R>
+class CodeMessageHandler : public MessageHandler
+{
+	R (C::*mFunc)(const Message&);
+
+public:
+	CodeMessageHandler(R (C::*func)(const Message&)) : mFunc(func) { }
+
+	MessageReply handle(GameObject *obj, const Message &msg) const 
+	{ return _MessageCall<R>::call(static_cast<C*>(static_cast<T*>(obj)), mFunc, msg); }
+};
+
+/*
+ * =====================================================================================
+ *        Class: MessageTable
+ *  Description: Gives a GameObject type handlers for messages. Messages a GameObject's
+ *               type has a handler for go to that handler instead of 'receiveMessage',
+ *               found by the message code in a table. GameObjectFactory::registerObjectType
+ *               gives one back, so handlers can be given like so:
+ *
+ *                   NGF_REGISTER_OBJECT_TYPE(Player)
+ *                       .onMessage<MsgSetTransform>(&Player::setTransform)
+ *                       .onMessage("jump", &Player::jump);
+ *
+ *               A handler is a member function taking the TypedMessage struct, or the
+ *               Message for handlers by name or code. It returns nothing, or the reply
+ *               (any copyable type). Handlers aren't inherited by derived types, and
+ *               should be given before GameObjects of the type are sent messages.
+ * =====================================================================================
+ */
+
+template<typename T>
+class MessageTable
+{
+public:
+	//Handle TypedMessage M with 'func'. M has to be given, like onMessage<MsgJump>(&Player::jump).
+	template<typename M, typename C, typename R>
+	MessageTable &onMessage(R (C::*func)(const M&));
+
+	//Handle Messages with the given name or code with 'func'.
+	template<typename C, typename R>
+	MessageTable &onMessage(const Ogre::String &name, R (C::*func)(const Message&))
+	{ return onMessage(MessageRegistry::getCode(name), func); }
+	template<typename C, typename R>
+	MessageTable &onMessage(unsigned int code, R (C::*func)(const Message&));
 };
 
 /*
@@ -221,12 +1041,15 @@ protected:
 	IDCreateFunctionMap mIDCreateFunctions;
 
 public:
+	typedef IDCreateFunctionMap::mapped_type IDCreateFunction;
+
 	//Register a GameObject type. Give the class as the template parameter, and the
 	//string name of the type as the string parameter. You can then use
 	//GameObjectManager::createObject to create an object of this type by passing a
-	//string.
+	//string. The options are passed on to GameObjectManager::setTypeOptions. Message
+	//handlers can be given with the MessageTable returned.
 	template<typename T>
-	void registerObjectType(Ogre::String type);
+	MessageTable<T> registerObjectType(Ogre::String type, const TypeOptions &options = TypeOptions());
 
 	//Create an object with the given type as a string. The type should be registered. 
 	//Use GameObjectManager::createObject instead for consistency. This is similar to 
@@ -243,6 +1066,10 @@ public:
         //Use this only if you're sure you know what you're doing!
 	NGF::GameObject *_createObject(Ogre::String type, ID id, Ogre::Vector3 pos, 
 			Ogre::Quaternion rot, PropertyList props, Ogre::String name);
+
+	//Get the function creating GameObjects of the given type with a given ID. It is
+	//empty if the type isn't registered.
+	IDCreateFunction _getIDCreateFunction(const Ogre::String &type) const;
 		
 	//------ Singleton functions ------------------------------
 	
@@ -251,6 +1078,25 @@ public:
 };
 
 
+//Run and record the parallel parts of GameObjectManager::tick. Defined in Ngf.cpp.
+class WorkerPool;
+struct CommandBuffer;
+
+//Memory for pooled GameObjects. Defined in Ngf.cpp.
+class ObjectPool;
+
+//Transforms of GameObjects, and a spatial hash of them. Defined in Ngf.cpp.
+class SpatialIndex;
+
+//Replies to requests given from any thread. Defined in Ngf.cpp.
+struct ReplyQueue;
+
+//Scheduled tasks. Defined in Ngf.cpp.
+class TaskWheel;
+
+//What the profiler has recorded. Defined in Ngf.cpp.
+struct Profiler;
+
 /*
  * =====================================================================================
  *        Class: GameObjectManager
@@ -261,12 +1107,376 @@ public:
 
 class GameObjectManager : public Ogre::Singleton<NGF::GameObjectManager>
 {
+	friend class GameObjectFactory;
+	friend class ProfileScope;
+
 protected:
-	std::map<ID,GameObject*> mGameObjectMap;
+	//The GameObjects live in a slot array indexed by the index part of their ID. Free slots
+	//are kept in a stack so finding an ID for a new GameObject doesn't need a search.
+	//A slot is reserved while its GameObject is being constructed, so GameObjects
+	//created by the constructor can't get the same ID.
+	struct ObjectSlot
+	{
+		GameObject *obj;
+		unsigned int generation;
+		bool reserved;
+
+		ObjectSlot() : obj(0), generation(0), reserved(false) { }
+	};
+	std::vector<ObjectSlot> mSlots;
+	std::vector<unsigned int> mFreeSlots;
+	unsigned int mNumObjects;
+
+	//Named GameObjects by name, for 'getByName' and the duplicate-name check.
+	typedef boost::unordered_map<Ogre::String, GameObject*> NameMap;
+	NameMap mNameMap;
+
 	GameObjectFactory *mObjectFactory;
 
 	std::vector<ID> mObjectsToDestroy;
 
+	//Used by 'destroyAll'.
+	std::vector<GameObject*> mDestroyList;
+	std::vector<fastdelegate::FastDelegate1<const std::vector<GameObject*>&> > mDestroyAllListeners;
+
+	//Per-type information. The tick lists hold the GameObjects of that type that want
+	//the unpaused or paused tick (indexed by TICKLIST_*), contiguous so ticking visits
+	//only subscribers, one type after another.
+	//
+	//GameObjects are grouped by tick interval. A group has one bucket per frame of the
+	//interval and ticks one bucket a frame, so each GameObject ticks once per interval.
+	//The time each bucket has waited is kept so it can be passed on in the FrameEvent.
+	enum
+	{
+		TICKLIST_UNPAUSED,
+		TICKLIST_PAUSED,
+		TICKLIST_INTERPOLATE,
+
+		NUM_TICKLISTS
+	};
+	struct TickGroup
+	{
+		unsigned int interval;
+		std::vector<std::vector<GameObject*> > buckets;
+		std::vector<Ogre::Real> elapsed;
+		unsigned int current;
+
+		TickGroup(unsigned int frames)
+		    : interval(frames), buckets(frames), elapsed(frames, 0), current(0) { }
+	};
+	struct TickList
+	{
+		std::vector<TickGroup*> groups;
+		bool dirty;
+
+		TickList() : dirty(false) { }
+		~TickList();
+	};
+	struct ObjectType
+	{
+		unsigned int index;
+		Ogre::String name;
+		TypeOptions options;
+
+		TickList tickLists[NUM_TICKLISTS];
+
+		ObjectPool *pool;
+
+		//Deactivated GameObjects kept for recycling.
+		std::vector<GameObject*> recycled;
+
+		//The GameObjects of this type.
+		std::vector<GameObject*> members;
+
+		//Message handlers (see MessageTable). Those for TypedMessages are indexed by 
+		//their code less NGF_MSG_TYPED_BASE, others are found by code.
+		std::vector<MessageHandler*> typedHandlers;
+		boost::unordered_map<unsigned int, MessageHandler*> codeHandlers;
+
+		ObjectType(unsigned int idx) : index(idx), pool(0) { }
+		~ObjectType();
+	};
+	std::vector<ObjectType*> mTypes;
+
+	//Transforms, created when first needed.
+	SpatialIndex *mSpatialIndex;
+	Ogre::Real mSpatialCellSize;
+
+	SpatialIndex *_getSpatialIndex();
+
+	//The GameObjects with each flag, indexed by FlagID.
+	std::vector<std::vector<GameObject*> > mFlagMembers;
+	static const std::vector<GameObject*> msNoMembers;
+
+	//Whether we're in the tick loop. Tick lists aren't reordered then, GameObjects
+	//leaving them are just NULLed out and the lists are compacted after the loop.
+	bool mTicking;
+
+	//Sets mTicking for the tick loop, and clears it and compacts the tick lists when it
+	//goes out of scope, even if a tick threw.
+	struct TickingScope
+	{
+		GameObjectManager *mgr;
+
+		TickingScope(GameObjectManager *manager) : mgr(manager) { mgr->mTicking = true; }
+		~TickingScope() { mgr->mTicking = false; mgr->_compactTickLists(); }
+	};
+	friend struct TickingScope;
+
+	//Tick phases. Each type ticks in one phase, and each phase is put in a level after
+	//the levels of the phases it comes after. Phases in the same level don't depend on
+	//each other, so their parallel ticks are run together. The schedule is rebuilt at the
+	//start of the tick if phases or types changed.
+	struct TickPhase
+	{
+		Ogre::String name;
+		std::vector<Ogre::String> after;
+		std::vector<ObjectType*> types;
+		int level;
+	};
+	std::vector<TickPhase> mPhases;
+	std::vector<std::vector<unsigned int> > mPhaseLevels;
+	bool mScheduleDirty;
+
+	void _buildSchedule();
+	void _tickType(ObjectType *type, unsigned int list, const Ogre::FrameEvent &evt);
+
+	//Posted messages. Each message is kept once in mPostedMessages, and each GameObject
+	//it's posted to gets an entry in mPosted. Messages posted while delivering go into
+	//these while mDelivering (and mDeliveringMessages) is gone through, so they wait for
+	//the next delivery. mDeliveryOrder is the slot index and place in mDelivering of
+	//each, sorted. Delivery is also done after the level mDeliveryLevel of the schedule
+	//(-1 for none).
+	struct PostedMessage
+	{
+		ID to;
+		unsigned int msg;
+		unsigned int request;
+
+		PostedMessage(ID id, unsigned int message, unsigned int req = ~0u) 
+		    : to(id), msg(message), request(req) { }
+	};
+	std::vector<PostedMessage> mPosted;
+	std::vector<PostedMessage> mDelivering;
+	std::vector<Message> mPostedMessages;
+	std::vector<Message> mDeliveringMessages;
+	std::vector<std::pair<unsigned int, unsigned int> > mDeliveryOrder;
+	unsigned int mMessageQueueCapacity;
+	Ogre::String mDeliveryPhase;
+	int mDeliveryLevel;
+	MessageQueueStats mQueueStats;
+	MessageQueueStats mLastQueueStats;
+
+	bool _postMessage(ID objID, const Message &msg, unsigned int request);
+
+	//The IDs of the group a message is being sent to, kept to be used again.
+	std::vector<ID> mGroupIDs;
+
+	//Event channels. Each has its subscribers one after another (so it can be sent to
+	//like any other group), with their subscriptions alongside. Subscriptions are kept in
+	//slots, with a generation that's bumped when one ends so old handles can be told apart.
+	struct Channel
+	{
+		Ogre::String name;
+		std::vector<GameObject*> members;
+		std::vector<unsigned int> subscriptions;
+	};
+	std::vector<Channel*> mChannels;
+	boost::unordered_map<Ogre::String, ChannelID> mChannelIDs;
+
+	struct SubscriptionSlot
+	{
+		GameObject *obj;
+		ChannelID channel;
+		unsigned int member;
+		unsigned int generation;
+
+		SubscriptionSlot() : obj(0), channel(0), member(0), generation(0) { }
+	};
+	std::vector<SubscriptionSlot> mSubscriptionSlots;
+	std::vector<unsigned int> mFreeSubscriptions;
+
+	//End a subscription, or all those of a GameObject. '_partitionSubscriptions' ends 
+	//those of all GameObjects that aren't managed any more at once.
+	void _unsubscribe(unsigned int slot);
+	void _unsubscribeAll(GameObject *obj);
+	void _partitionSubscriptions();
+
+	//Requests, kept in slots like subscriptions. mCurrentRequest is the one whose message
+	//is being handled, if any. Replies given with 'fulfilRequest' wait in mReplyQueue 
+	//until 'completeRequests'.
+	struct RequestSlot
+	{
+		bool used;
+		bool deferred;
+		ReplyStatus status;
+		MessageReply reply;
+		ReplyFunction onReply;
+		GameObject *from;
+		ID fromID;
+		unsigned int generation;
+
+		RequestSlot() : used(false), deferred(false), status(REPLY_PENDING), from(0), fromID(0), generation(0) { }
+	};
+	std::vector<RequestSlot> mRequests;
+	std::vector<unsigned int> mFreeRequests;
+	unsigned int mCurrentRequest;
+	ReplyQueue *mReplyQueue;
+
+	bool _isRequest(const RequestTicket &ticket) const
+	{
+		return ticket.index < mRequests.size() && mRequests[ticket.index].used 
+			&& mRequests[ticket.index].generation == ticket.generation;
+	}
+	void _deliverRequest(GameObject *obj, unsigned int request, const Message &msg);
+	void _completeRequest(unsigned int request, ReplyStatus status, const MessageReply &reply);
+	void _releaseRequest(unsigned int request);
+
+	//Tasks, created when first needed. The wheel turns with unpaused time.
+	TaskWheel *mTaskWheel;
+	Ogre::Real mTaskResolution;
+
+	TaskWheel *_getTaskWheel();
+
+	//Created when profiling is first turned on.
+	Profiler *mProfiler;
+
+	//Runs the ticks of one list through all the phases.
+	void _tickStep(unsigned int list, const Ogre::FrameEvent &evt);
+
+	//Deferrable unpaused ticks, in rings by priority. mDeferredOrder has the rings from
+	//highest priority to lowest. Each frame a ring is gone round from where the last
+	//frame stopped, so GameObjects put off tick first next time. A GameObject in a ring
+	//has DEFERRED_GROUP as its unpaused tick group, and the ring as its bucket. Times are
+	//on mDeferredClock, the unpaused time so far.
+	static const unsigned int DEFERRED_GROUP = ~0u;
+	struct DeferredRing
+	{
+		int priority;
+		std::vector<GameObject*> objs;
+		std::vector<double> lastTicks;
+		unsigned int next;
+		bool dirty;
+
+		DeferredRing(int prio) : priority(prio), next(0), dirty(false) { }
+	};
+	std::vector<DeferredRing*> mDeferredRings;
+	std::vector<unsigned int> mDeferredOrder;
+	std::vector<unsigned int> mDeferredPass;
+	double mDeferredClock;
+	Ogre::Real mTickBudget;
+	TickBudgetStats mBudgetStats;
+	TickBudgetStats mBudgetTotals;
+
+	void _addToDeferredRing(GameObject *obj);
+	void _removeFromDeferredRing(GameObject *obj);
+	void _compactDeferredRings(bool managedOnly);
+
+	//Runs the deferrable ticks until they've taken the budget, then one from each ring
+	//left.
+	void _tickDeferred(Ogre::Real time);
+
+	//Fixed time step. The time not yet simulated is kept in mTimeAccumulator.
+	Ogre::Real mFixedTimeStep;
+	unsigned int mMaxSubSteps;
+	Ogre::Real mTimeAccumulator;
+	Ogre::Real mInterpolationAlpha;
+
+	//Parallel ticking. While mParallelPhase is set, calls from the ticks running on the
+	//workers are recorded into per-worker CommandBuffers. After the phase they are done
+	//in the order they would have happened in a serial tick.
+	WorkerPool *mWorkerPool;
+	std::vector<CommandBuffer*> mCommandBuffers;
+	struct ParallelItem
+	{
+		GameObject *obj;
+		unsigned int typeIndex;
+		Ogre::FrameEvent evt;
+	};
+	std::vector<ParallelItem> mParallelItems;
+	bool mParallelPhase;
+
+	typedef fastdelegate::FastDelegate<GameObject* (Ogre::Vector3, Ogre::Quaternion, PropertyList, Ogre::String)>
+		CreateFunction;
+
+	//Get the CommandBuffer of the calling thread if it is running a parallel tick, else NULL.
+	CommandBuffer *_getCommandBuffer() const;
+
+	//Record a creation, or run the recorded commands.
+	bool _deferCreate(CreateFunction func, const Ogre::Vector3 &pos, const Ogre::Quaternion &rot, 
+		const PropertyList &properties, const Ogre::String &name);
+	void _runCommandBuffers();
+
+	//Where each recorded command is, in serial tick order. Kept so running the commands
+	//doesn't allocate.
+	struct CommandRef
+	{
+		unsigned int item;
+		unsigned int buffer;
+		unsigned int index;
+
+		bool operator<(const CommandRef &other) const { return item < other.item; }
+	};
+	std::vector<CommandRef> mCommandOrder;
+
+	//Runs the unpaused ticks of the parallel types in the phases of a level.
+	void _parallelTick(unsigned int level, const Ogre::FrameEvent &evt);
+	friend class ParallelTickJob;
+
+	//Returns the ID the next GameObject created should get. Doesn't reserve it,
+	//'_createObject' does before running any constructor.
+	ID _nextFreeID();
+
+	//Reserve the slot of an ID for a GameObject being created, or give it back if the
+	//creation failed (making the ID stale).
+	void _reserveSlot(ID id);
+	void _releaseSlot(unsigned int index);
+
+	//Puts a newly created GameObject in its slot, or takes the GameObject in a slot out
+	//(freeing the slot). Keeps the name index up to date. The position and rotation are
+	//those it was created with.
+	void _insertObject(GameObject *obj, const Ogre::Vector3 &pos, const Ogre::Quaternion &rot);
+	void _removeObject(unsigned int index);
+
+	//Get memory for a GameObject of the given type from its pool, or NULL if it isn't
+	//pooled. Give it back, or delete a GameObject whichever way it was made.
+	void *_allocateObject(unsigned int typeIndex, size_t size);
+	void _deallocateObject(unsigned int typeIndex, void *mem);
+	void _freeObject(GameObject *obj);
+	PoolStats _getPoolStats(unsigned int typeIndex);
+
+	//Recycling. '_recycleObject' keeps a GameObject that was taken out of its slot if its 
+	//type has room, returning whether it did. '_reuseObject' creates a GameObject from a 
+	//kept one, returning NULL if there is none.
+	bool _recycleObject(GameObject *obj);
+	GameObject *_reuseObject(unsigned int typeIndex, ID id, const Ogre::Vector3 &pos, 
+		const Ogre::Quaternion &rot, const PropertyList &properties, const Ogre::String &name);
+
+	//Get the information for the type with the given index, creating it if needed.
+	ObjectType *_getType(unsigned int typeIndex);
+	static unsigned int _newTypeIndex();
+
+	//Throws if the options don't go together.
+	static void _checkTypeOptions(const TypeOptions &options);
+
+	//Put a GameObject into or take it out of the tick lists of its type.
+	void _addToTickList(GameObject *obj, unsigned int list);
+	void _removeFromTickList(GameObject *obj, unsigned int list);
+	void _compactTickLists();
+
+	//Take all GameObjects that aren't managed any more out of the tick lists, or the
+	//type and flag indices, at once.
+	void _partitionTickLists();
+	void _partitionIndices();
+
+	//Put a GameObject into or take it out of the type and flag indices.
+	void _addToIndices(GameObject *obj);
+	void _removeFromIndices(GameObject *obj);
+
+	//Move a group on a frame: returns the bucket to tick and fills in its FrameEvent.
+	std::vector<GameObject*> &_advanceTickGroup(TickGroup *group, const Ogre::FrameEvent &evt, 
+		Ogre::FrameEvent &groupEvt);
+
 public:
 
 	typedef fastdelegate::FastDelegate1<GameObject*> ForEachFunction;
@@ -275,7 +1485,7 @@ public:
 	
 	GameObjectManager();
 
-	~GameObjectManager() { destroyAll(); delete mObjectFactory; }
+	~GameObjectManager();
 
 	//------ Tick function ------------------------------------
 
@@ -283,6 +1493,43 @@ public:
 	//the game is paused, and pass it the Ogre::FrameEvent.
 	void tick(bool paused, const Ogre::FrameEvent & evt);
 
+	//Run the unpaused ticks in fixed steps of 'step' seconds instead of once a frame. Each
+	//frame's time is added up, and as many steps as fit are run, but no more than
+	//'maxSubSteps' (the rest of the time is dropped so slow frames don't snowball).
+	//The steps get 'step' as the time in their FrameEvent. Paused and interpolated
+	//ticks still happen once a frame. A step of 0 (the default) turns this off.
+	//'maxSubSteps' must be at least 1.
+	void setFixedTimeStep(Ogre::Real step, unsigned int maxSubSteps = 5);
+
+	//Get the fixed time step (0 if off).
+	Ogre::Real getFixedTimeStep() const { return mFixedTimeStep; }
+
+	//How far (0 to 1) the last frame was between fixed steps. 1 with no fixed time step.
+	Ogre::Real getInterpolationAlpha() const { return mInterpolationAlpha; }
+
+	//Run the unpaused ticks of types registered with TypeOptions().parallel() on this
+	//many threads, counting the one calling 'tick'. They run after the other unpaused 
+	//ticks. Each thread takes 'grain' GameObjects at a time, and takes work from the
+	//others once it runs out. 0 or 1 threads (the default) means no parallel ticking.
+	void setTickThreads(unsigned int numThreads, unsigned int grain = 16);
+
+	//Get the number of threads ticking.
+	unsigned int getTickThreads() const;
+
+	//------ Tick phases --------------------------------------
+
+	//Add a tick phase. 'after' is a space-separated list of the phases that have to be
+	//done before this one. Phases that don't have to be done before one another may have
+	//their parallel ticks run at the same time. These phases exist to start with:
+	//
+	//    PrePhysics -> Physics -> Default, PostPhysics -> Late
+	//
+	//Types tick in 'Default' unless registered with TypeOptions().phase(...).
+	void addTickPhase(const Ogre::String &name, const Ogre::String &after = "");
+
+	//Whether there is a tick phase with the given name.
+	bool hasTickPhase(const Ogre::String &name) const;
+
 	//------ Singleton functions ------------------------------
 
 	static GameObjectManager* getSingletonPtr(void);
@@ -291,7 +1538,8 @@ public:
 	//------ Create/Destroy functions -------------------------
 
 	//Creates a GameObject of the given type. Returns a pointer to the GameObject created.
-	//Give name "noname" if you want the GameObject to not have a name.
+	//Give name "noname" if you want the GameObject to not have a name. From a parallel
+	//tick, the GameObject is created later and NULL is returned.
 	template<typename T>
 	GameObject* createObject(Ogre::Vector3 pos, Ogre::Quaternion rot, PropertyList properties = PropertyList(), 
 		Ogre::String name = "");
@@ -304,6 +1552,15 @@ public:
 		return mObjectFactory->createObject(type, pos, rot, properties, name);
 	}
 
+	//Creates many GameObjects at once, with their types given as strings. Each type is only
+	//looked up once, and the names are all checked before anything is created. Returns
+	//the GameObjects created in order, with NULL for those of unregistered types. 
+	std::vector<GameObject*> createObjects(const ObjectSpawn *spawns, unsigned int numSpawns);
+	std::vector<GameObject*> createObjects(const std::vector<ObjectSpawn> &spawns)
+	{
+		return spawns.empty() ? std::vector<GameObject*>() : createObjects(&spawns[0], spawns.size());
+	}
+
 	//Creates a GameObject of the given type and ID. Returns a pointer to the GameObject
 	//created.  Give name "noname" if you want the GameObject to not have a name.
         //
@@ -324,25 +1581,183 @@ public:
 	}
 
 	//Destroys the GameObject with the given ID.
-	//Returns false if it was not found and true if it was.
+	//Returns false if it was not found and true if it was. From a parallel tick,
+	//the GameObject is destroyed after the parallel part.
 	bool destroyObject(ID objID);
 
 	//Requests the GameObjectManager to destroy a GameObject soon. This is needed
 	//if an object wants to destroy itself, or for other crazy situations.
-	void requestDestroy(ID objID) { mObjectsToDestroy.push_back(objID); }
+	void requestDestroy(ID objID);
 
-	//Destroys all the GameObjects that exist.
+	//Destroys all the GameObjects that exist. GameObjects kept for recycling are
+	//destroyed too, as they might refer to things of the level that is going away.
+	//All of them are taken out of the GameObjectManager before any is deleted.
 	void destroyAll(void);
 
+	//Called by 'destroyAll' with all the GameObjects it's about to destroy, so things
+	//like a physics world can let go of them in one go instead of one by one.
+	typedef fastdelegate::FastDelegate1<const std::vector<GameObject*>&> DestroyAllFunction;
+	void addDestroyAllListener(DestroyAllFunction func);
+	void removeDestroyAllListener(DestroyAllFunction func);
+
+	//Destroys the GameObjects kept for recycling.
+	void clearRecycled(void);
+
+	//------ Type functions -----------------------------------
+
+	//Every GameObject type gets a small index, used to find its per-type information.
+	template<typename T>
+	static unsigned int getTypeIndex() { static unsigned int index = _newTypeIndex(); return index; }
+
+	//Set the options for a GameObject type. GameObjectFactory::registerObjectType does
+	//this for you. Affects GameObjects created afterwards. Throws if they're deferrable
+	//and parallel.
+	template<typename T>
+	void setTypeOptions(const TypeOptions &options) 
+	{ _checkTypeOptions(options); _getType(getTypeIndex<T>())->options = options; mScheduleDirty = true; }
+
+	//Get the options for a GameObject type.
+	template<typename T>
+	const TypeOptions &getTypeOptions() { return _getType(getTypeIndex<T>())->options; }
+
+	//Get the statistics of a type's pool (all 0 if it has none).
+	template<typename T>
+	PoolStats getPoolStats() { return _getPoolStats(getTypeIndex<T>()); }
+
+	//Called by GameObject::setTickFlags once the GameObject is managed.
+	void _setTickFlags(GameObject *obj, unsigned int flags);
+
+	//Called by GameObject::setTickInterval once the GameObject is managed.
+	void _setTickInterval(GameObject *obj, unsigned int frames);
+
+	//Called by GameObject::setDeferrableTick once the GameObject is managed.
+	void _setDeferrableTick(GameObject *obj, bool deferrable, int priority);
+
+	//Whether a GameObject's unpaused tick can be put off, and its priority.
+	bool _isTickDeferrable(const GameObject *obj);
+	int _getTickPriority(const GameObject *obj);
+
+	//End the subscriptions and tasks of a GameObject that is leaving, or that never got
+	//in because its creation failed after it made some.
+	void _forgetObject(GameObject *obj);
+
+	//Give a type a handler for a message code, replacing any it had. Takes ownership of
+	//the handler. Use MessageTable.
+	void _setMessageHandler(unsigned int typeIndex, unsigned int code, MessageHandler *handler);
+
+	//Get the handler the type of a GameObject has for a message code, or NULL. GameObjects
+	//not in the GameObjectManager (yet) have none.
+	MessageHandler *_getMessageHandler(const GameObject *obj, unsigned int code) const
+	{
+		if (!obj->mManaged)
+			return NULL;
+
+		const ObjectType *type = mTypes[obj->mTypeIndex];
+		if (code >= NGF_MSG_TYPED_BASE)
+		{
+			unsigned int index = code - NGF_MSG_TYPED_BASE;
+			return index < type->typedHandlers.size() ? type->typedHandlers[index] : NULL;
+		}
+		if (type->codeHandlers.empty())
+			return NULL;
+
+		boost::unordered_map<unsigned int, MessageHandler*>::const_iterator iter = type->codeHandlers.find(code);
+		return iter == type->codeHandlers.end() ? NULL : iter->second;
+	}
+
+	//Called when a managed GameObject gets or loses a flag.
+	void _addToFlagIndex(GameObject *obj, FlagID flag);
+	void _removeFromFlagIndex(GameObject *obj, FlagID flag);
+
+	//------ Group functions ----------------------------------
+
+	//The GameObjects of a group can be gone through with a range. The range is only good
+	//until GameObjects join or leave the group, so copy it first if you want to do that 
+	//while going through it (destroying or creating GameObjects, changing flags).
+	typedef std::vector<GameObject*>::const_iterator ObjectIterator;
+	typedef std::pair<ObjectIterator, ObjectIterator> ObjectRange;
+
+	//Get the GameObjects that have a flag.
+	ObjectRange getObjectsWithFlag(FlagID flag) const;
+	ObjectRange getObjectsWithFlag(const Ogre::String &flag) const;
+
+	//Get the GameObjects of a type, not counting derived types. The string version takes
+	//the name the type was registered with.
+	template<typename T>
+	ObjectRange getObjectsOfType() { return _getTypeMembers(_getType(getTypeIndex<T>())); }
+	ObjectRange getObjectsOfType(const Ogre::String &type) const;
+
+	//Get the range of a type's GameObjects.
+	static ObjectRange _getTypeMembers(const ObjectType *type) 
+	{ return ObjectRange(type->members.begin(), type->members.end()); }
+
+	//------ Transform functions ------------------------------
+
+	//GameObjects can have a transform kept by the GameObjectManager, so they can be found
+	//by where they are. It's kept in arrays of its own (not in the GameObject) and in a
+	//grid of cells (a spatial hash) that is updated as it moves. A GameObject has none
+	//until it's given one, or its type is registered with TypeOptions().transform().
+	//Don't change transforms from parallel ticks.
+
+	//Set the position and rotation of a GameObject, giving it a transform if it has none.
+	void setTransform(GameObject *obj, const Ogre::Vector3 &pos, const Ogre::Quaternion &rot);
+
+	//Set the position of a GameObject, giving it a transform (with no rotation) if it has none.
+	void setPosition(GameObject *obj, const Ogre::Vector3 &pos);
+
+	//Set the rotation of a GameObject. It must have a transform.
+	void setOrientation(GameObject *obj, const Ogre::Quaternion &rot);
+
+	//Get the position or rotation of a GameObject. It must have a transform.
+	Ogre::Vector3 getPosition(const GameObject *obj) const;
+	Ogre::Quaternion getOrientation(const GameObject *obj) const;
+
+	//Whether a GameObject has a transform.
+	bool hasTransform(const GameObject *obj) const { return obj->mTransformIndex != ~0u; }
+
+	//Take a GameObject's transform away.
+	void removeTransform(GameObject *obj);
+
+	//Set the size of the spatial hash's cells. Queries are quickest when it's around the
+	//size of the usual query. It's 10 to start with. The hash is about a million cells
+	//across each way, anything further out shares the edge cells: queries there still
+	//give the right answer, only slower.
+	void setSpatialCellSize(Ogre::Real size);
+	Ogre::Real getSpatialCellSize() const { return mSpatialCellSize; }
+
+	//Find the GameObjects with transforms within 'radius' of 'center', or inside the box
+	//from 'min' to 'max'. Their IDs are added to 'result' (in no order), and the number
+	//found is returned.
+	unsigned int queryRadius(const Ogre::Vector3 &center, Ogre::Real radius, std::vector<ID> &result) const;
+	unsigned int queryBox(const Ogre::Vector3 &min, const Ogre::Vector3 &max, std::vector<ID> &result) const;
+
+	//Find the 'k' GameObjects with transforms nearest to 'center'. Their IDs are added to
+	//'result', nearest first, and the number found (at most 'k') is returned.
+	unsigned int queryNearest(const Ogre::Vector3 &center, unsigned int k, std::vector<ID> &result) const;
+
 	//------ Miscellaneous functions --------------------------
 
 	//Returns a pointer to the GameObject with the given ID. If it was
-	//not found, a NULL pointer will be returned.
+	//not found, a NULL pointer will be returned. This is also the case for
+	//IDs of destroyed GameObjects, even if their slot has been reused.
 	GameObject* getByID(ID objID) const;
 
+	//Returns whether the given ID refers to a GameObject that still exists.
+	bool isValid(ID objID) const { return getByID(objID) != NULL; }
+
+	//Returns the number of GameObjects that exist.
+	unsigned int getNumObjects() const { return mNumObjects; }
+
+	//Get the slot index or generation of an ID, or make an ID from them.
+	static unsigned int getIDIndex(ID objID) { return objID & ((1u << NGF_ID_INDEX_BITS) - 1); }
+	static unsigned int getIDGeneration(ID objID) 
+	{ return (objID >> NGF_ID_INDEX_BITS) & ((1u << NGF_ID_GENERATION_BITS) - 1); }
+	static ID makeID(unsigned int index, unsigned int generation) 
+	{ return index | ((generation & ((1u << NGF_ID_GENERATION_BITS) - 1)) << NGF_ID_INDEX_BITS); }
+
 	//Returns a pointer to the GameObject with the given name. If not found,
 	//a NULL pointer is returned.
-	GameObject* getByName(Ogre::String name);
+	GameObject* getByName(const Ogre::String &name) const;
 
 	//Calls the function passed for each GameObject that exists. One argument
 	//is passed to that function, which is the GameObject. Quite useful if
@@ -351,13 +1766,271 @@ public:
 
 	//------ Messaging functions ------------------------------
 
-	//This function sends a message to the GameObject.
-	void sendMessage(GameObject *obj, Message msg) const;
+	//This function sends a message to the GameObject. It goes to the handler the 
+	//GameObject's type has for it (see MessageTable), or else to 'receiveMessage'.
+	void sendMessage(GameObject *obj, const Message &msg) const;
+	template<typename M>
+	void sendMessage(GameObject *obj, const TypedMessage<M> &msg) const;
 
 	//This function sends the message, and gives a reply. GameObjects can reply using 
-	//NGF_SEND_REPLY(reply) in a GameObject::receiveMessage() function.
+	//NGF_SEND_REPLY(reply) in a GameObject::receiveMessage() function, or by returning
+	//it from a handler.
+	template<class ReturnType>
+	ReturnType sendMessageWithReply(GameObject *obj, const Message &msg);
+	template<class ReturnType, typename M>
+	ReturnType sendMessageWithReply(GameObject *obj, const TypedMessage<M> &msg);
+
+	//Like sendMessageWithReply, but instead of throwing gives what became of the message
+	//with the reply, so asking for replies that may not come is cheap. Like so:
+	//
+	//    NGF::Reply<int> health = gom->trySendMessageWithReply<int>(obj, MsgGetHealth());
+	//    if (health.ok()) ...
+	template<class ReturnType>
+	Reply<ReturnType> trySendMessageWithReply(GameObject *obj, const Message &msg);
+	template<class ReturnType, typename M>
+	Reply<ReturnType> trySendMessageWithReply(GameObject *obj, const TypedMessage<M> &msg);
+
+	//Give a message to its handler, or 'receiveMessage', now.
+	MessageReply _dispatchMessage(GameObject *obj, const Message &msg) const
+	{
+		NGF_PROFILE(obj, PROFILE_MESSAGE);
+		MessageHandler *handler = _getMessageHandler(obj, msg.code);
+		return handler ? handler->handle(obj, msg) : obj->receiveMessage(msg);
+	}
+
+	//------ Posted messages ----------------------------------
+
+	//Messages can be posted instead of sent. They are queued and delivered later all at
+	//once, grouped by GameObject, instead of making the sender wait on the receiver. 
+	//Messages to a GameObject are delivered in the order they were posted. Those posted
+	//while delivering wait for the next delivery, and those to GameObjects gone by then
+	//are dropped. Delivery is at the end of the tick, and after the delivery phase if
+	//one is set.
+
+	//Post a message. Returns false, dropping the message, if the queue is full (or there
+	//is no GameObject). From a parallel tick, it is posted after the parallel part (and
+	//true is returned). TypedMessages are posted as a Message with their code (see 
+	//TypedMessage). Posting by ID has its own name so a literal 0 can't mean either.
+	bool postMessage(GameObject *obj, const Message &msg) { return obj ? postMessageByID(obj->getID(), msg) : false; }
+	bool postMessageByID(ID objID, const Message &msg);
+	template<typename M>
+	bool postMessage(GameObject *obj, const TypedMessage<M> &msg) 
+	{ return obj ? postMessageByID(obj->getID(), msg) : false; }
+	template<typename M>
+	bool postMessageByID(ID objID, const TypedMessage<M> &msg) 
+	{ return postMessageByID(objID, (Message(M::getCode()), static_cast<const M&>(msg))); }
+
+	//Deliver the messages posted so far now.
+	void deliverMessages();
+
+	//Also deliver posted messages after the ticks of the given tick phase (and those of
+	//phases running alongside it), like "Physics". "" (the default) means only at the 
+	//end of the tick.
+	void setMessageDeliveryPhase(const Ogre::String &phase) { mDeliveryPhase = phase; mScheduleDirty = true; }
+	const Ogre::String &getMessageDeliveryPhase() const { return mDeliveryPhase; }
+
+	//Set how many messages can wait to be delivered. 0 (the default) means any number.
+	void setMessageQueueCapacity(unsigned int capacity) { mMessageQueueCapacity = capacity; }
+	unsigned int getMessageQueueCapacity() const { return mMessageQueueCapacity; }
+
+	//Get the number of messages waiting to be delivered.
+	unsigned int getNumPostedMessages() const { return mPosted.size(); }
+
+	//Get what happened to posted messages in the last tick, counting those posted since
+	//the tick before it.
+	const MessageQueueStats &getMessageQueueStats() const { return mLastQueueStats; }
+
+	//------ Group messages -----------------------------------
+
+	//Send a message to each GameObject of a group, as given by getObjectsWithFlag or
+	//getObjectsOfType, like sendMessageToGroup(getObjectsWithFlag("Enemy"), msg). The
+	//message is made once and given to each by const reference. Those that join the
+	//group while it's being sent don't get it, and those destroyed before their turn are
+	//skipped. Returns the number of GameObjects it was sent to.
+	unsigned int sendMessageToGroup(ObjectRange group, const Message &msg);
+	template<typename M>
+	unsigned int sendMessageToGroup(ObjectRange group, const TypedMessage<M> &msg)
+	{ return sendMessageToGroup(group, (Message(M::getCode()), static_cast<const M&>(msg))); }
+
+	//Post a message to each GameObject of a group (see postMessage). The message is kept
+	//once for all of them. If the queue hasn't room for all of them, it's posted to none.
+	//Returns the number of GameObjects it was posted to.
+	unsigned int postMessageToGroup(ObjectRange group, const Message &msg);
+	template<typename M>
+	unsigned int postMessageToGroup(ObjectRange group, const TypedMessage<M> &msg)
+	{ return postMessageToGroup(group, (Message(M::getCode()), static_cast<const M&>(msg))); }
+
+	//------ Event channels -----------------------------------
+
+	//GameObjects can subscribe to named channels. A message published on a channel goes
+	//to its subscribers (in no particular order) like with sendMessageToGroup, without
+	//the publisher having to know who they are. Subscriptions end when the GameObject is
+	//destroyed. Don't subscribe or unsubscribe from parallel ticks.
+
+	//Get the ChannelID for a name, making the channel if needed.
+	ChannelID getChannel(const Ogre::String &name);
+
+	//Subscribe a GameObject to a channel. It can be done in the GameObject's constructor.
+	//Gives a handle to the subscription, the one it had if it was subscribed already.
+	Subscription subscribe(GameObject *obj, ChannelID channel);
+	Subscription subscribe(GameObject *obj, const Ogre::String &channel) { return subscribe(obj, getChannel(channel)); }
+
+	//End a subscription. Returns false if it had already ended.
+	bool unsubscribe(const Subscription &sub);
+
+	//Whether a subscription hasn't ended.
+	bool isSubscribed(const Subscription &sub) const
+	{
+		return sub.index < mSubscriptionSlots.size() && mSubscriptionSlots[sub.index].obj 
+			&& mSubscriptionSlots[sub.index].generation == sub.generation;
+	}
+
+	//Get the subscribers of a channel. A channel that doesn't exist has none.
+	ObjectRange getSubscribers(ChannelID channel) const;
+	ObjectRange getSubscribers(const Ogre::String &channel) const;
+
+	//Send or post (see postMessageToGroup) a Message or TypedMessage to the subscribers of
+	//a channel, given by ChannelID or name. Returns the number of subscribers it went to.
+	template<typename ChannelType, typename MessageType>
+	unsigned int publish(const ChannelType &channel, const MessageType &msg) 
+	{ return sendMessageToGroup(getSubscribers(channel), msg); }
+	template<typename ChannelType, typename MessageType>
+	unsigned int publishQueued(const ChannelType &channel, const MessageType &msg) 
+	{ return postMessageToGroup(getSubscribers(channel), msg); }
+
+	//------ Requests -----------------------------------------
+
+	//A request is a message posted (see postMessage) whose reply comes back later, so
+	//the GameObject asking needn't wait on one that takes a while to work out. The
+	//receiver can reply right away like with sendMessageWithReply, or call 'deferReply'
+	//while handling the message and give the reply later with 'fulfilRequest' (from any
+	//thread, say once a batch of such work is done). The reply is given to the callback
+	//on the main thread, when messages are delivered. Don't make requests from parallel
+	//ticks.
+
+	//Request a reply to a message. If 'from' is given and is gone when the reply comes,
+	//the callback isn't called. Requests with a callback are released after it's called.
+	RequestTicket requestReply(GameObject *to, const Message &msg, ReplyFunction onReply = ReplyFunction(), 
+		GameObject *from = 0);
+	template<typename M>
+	RequestTicket requestReply(GameObject *to, const TypedMessage<M> &msg, ReplyFunction onReply = ReplyFunction(), 
+		GameObject *from = 0)
+	{ return requestReply(to, (Message(M::getCode()), static_cast<const M&>(msg)), onReply, from); }
+
+	//Called by the receiver of a request while handling its message, to reply later with
+	//'fulfilRequest'. Gives the ticket of the request.
+	RequestTicket deferReply();
+
+	//Give the reply to a deferred request. Can be called from any thread.
+	void fulfilRequest(const RequestTicket &ticket, const MessageReply &reply);
+
+	//Get what became of a request, and the reply if there is one.
+	ReplyStatus getRequestStatus(const RequestTicket &ticket) const
+	{ return _isRequest(ticket) ? mRequests[ticket.index].status : REPLY_UNKNOWN; }
 	template<class ReturnType>
-	ReturnType sendMessageWithReply(GameObject *obj, Message msg);
+	Reply<ReturnType> getRequestReply(const RequestTicket &ticket) const
+	{
+		ReplyStatus status = getRequestStatus(ticket);
+		return status == REPLY_OK ? _toReply<ReturnType>(mRequests[ticket.index].reply) : Reply<ReturnType>::failed(status);
+	}
+
+	//Forget a request. Release requests with no callback once their reply has been got.
+	//Released requests get no callback, and their replies are thrown away.
+	void releaseRequest(const RequestTicket &ticket) { if (_isRequest(ticket)) _releaseRequest(ticket.index); }
+
+	//Give the replies given with 'fulfilRequest' so far to their requests, calling the
+	//callbacks. This is done when messages are delivered.
+	void completeRequests();
+
+	//------ Tasks ---------------------------------------------------------------------
+	
+	//Call 'func' once 'delay' seconds of unpaused time have passed. Tasks are kept in a
+	//hierarchical timing wheel, so scheduling, cancelling and firing are all O(1). Due
+	//tasks are called in the order they are due, after the unpaused ticks of the frame
+	//and before posted messages are delivered. If 'owner' is given the task is cancelled 
+	//when it is destroyed. Call from the main thread only.
+	TaskHandle scheduleTask(Ogre::Real delay, TaskFunction func, GameObject *owner = 0);
+
+	//Returns whether the task was still pending.
+	bool cancelTask(const TaskHandle &task);
+
+	//Cancel all the tasks owned by a GameObject.
+	void cancelTasks(GameObject *owner);
+
+	bool isTaskPending(const TaskHandle &task) const;
+
+	//Time until a pending task is due, or -1 if it isn't pending.
+	Ogre::Real getTaskTimeLeft(const TaskHandle &task) const;
+
+	unsigned int getNumTasks() const;
+
+	//The unpaused time the tasks have seen so far.
+	Ogre::Real getTaskTime() const;
+
+	//Tasks are called on the first wheel step at or after their time, steps are 'seconds'
+	//long (0.01 by default). Can only be changed while no tasks are pending.
+	void setTaskResolution(Ogre::Real seconds);
+	Ogre::Real getTaskResolution() const { return mTaskResolution; }
+
+	//Turn the wheel, calling due tasks. 'tick' does this with the unpaused time.
+	void advanceTasks(Ogre::Real time);
+
+	//------ Tick budget ---------------------------------------------------------------
+	
+	//Once the deferrable unpaused ticks (see TypeOptions::deferrable) have taken 'seconds'
+	//in a frame, put off those not done yet to the next frame. Higher priorities go 
+	//first, but at least one of each priority is done each frame, so none are starved: 
+	//a GameObject waits at most as many frames as there are GameObjects of its priority.
+	//0, the default, means no limit.
+	void setTickBudget(Ogre::Real seconds) { mTickBudget = seconds > 0 ? seconds : 0; }
+	Ogre::Real getTickBudget() const { return mTickBudget; }
+
+	//What the budget did last frame, and since the totals were last reset.
+	const TickBudgetStats &getTickBudgetStats() const { return mBudgetStats; }
+	const TickBudgetStats &getTickBudgetTotals() const { return mBudgetTotals; }
+	void resetTickBudgetTotals() { mBudgetTotals = TickBudgetStats(); }
+
+	//------ Profiling -----------------------------------------------------------------
+	
+	//When built with NGF_ENABLE_PROFILER, the time taken by ticks, messages, creation,
+	//destruction, Python events and level loading is added up for each GameObject type,
+	//along with the number of calls and of GameObjects allocated. The tick of the
+	//GameObjectManager itself, and level loading, are under type "". Off by default.
+	//Throws if called during the parallel part of a tick (see TypeOptions::parallel),
+	//since the tick workers check whether it's on without locking.
+	void setProfiling(bool enable);
+	bool isProfiling() const { return ProfileScope::isEnabled(); }
+
+	//Also keep each timed call (each type's part of a tick, each message etc.), up to
+	//'maxEvents' of them, to be written out with 'writeProfileTrace'.
+	void setProfileTracing(bool enable, unsigned int maxEvents = 1000000);
+
+	//What the profiler saw of a type, or of all the types seen, since the last reset.
+	ProfileStats getProfileStats(const Ogre::String &type) const;
+	std::vector<std::pair<Ogre::String, ProfileStats> > getProfileStats() const;
+
+	//Forget the stats and the kept calls.
+	void resetProfile();
+
+	//Write the kept calls as Chrome trace-event JSON, which chrome://tracing and Perfetto
+	//can show. Throws if the file can't be written.
+	void writeProfileTrace(const Ogre::String &filename) const;
+	void writeProfileTrace(std::ostream &out) const;
+
+	//Turn a reply into ReturnType, throwing if there is none or it's of another type.
+	template<class ReturnType>
+	static ReturnType _castReply(const MessageReply &reply);
+
+	//Turn a reply into a Reply.
+	template<class ReturnType>
+	static Reply<ReturnType> _toReply(const MessageReply &reply)
+	{
+		if (reply.empty())
+			return Reply<ReturnType>::failed(REPLY_NONE);
+
+		boost::optional<ReturnType> val = reply.find<ReturnType>();
+		return val ? Reply<ReturnType>(*val) : Reply<ReturnType>::failed(REPLY_BAD_TYPE);
+	}
 
 };
 
@@ -500,21 +2173,46 @@ public:
 //-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-
 
 template<typename T>
-void GameObjectFactory::registerObjectType(Ogre::String type)
+MessageTable<T> GameObjectFactory::registerObjectType(Ogre::String type, const TypeOptions &options)
 {
+	GameObjectManager *mgr = GameObjectManager::getSingletonPtr();
+	mgr->setTypeOptions<T>(options);
+	mgr->_getType(GameObjectManager::getTypeIndex<T>())->name = type;
+
 	mCreateFunctions[type] = fastdelegate::MakeDelegate(GameObjectManager::getSingletonPtr(), &GameObjectManager::createObject<T>);
 	mIDCreateFunctions[type] = fastdelegate::MakeDelegate(GameObjectManager::getSingletonPtr(), &GameObjectManager::_createObject<T>);
+
+	return MessageTable<T>();
+}
+//--------------------------------------------------------------------------------------
+template<typename T>
+template<typename M, typename C, typename R>
+MessageTable<T> &MessageTable<T>::onMessage(R (C::*func)(const M&))
+{
+	GameObjectManager::getSingleton()._setMessageHandler(GameObjectManager::getTypeIndex<T>(), 
+		M::getCode(), new TypedMessageHandler<T, C, M, R>(func));
+	return *this;
+}
+//--------------------------------------------------------------------------------------
+template<typename T>
+template<typename C, typename R>
+MessageTable<T> &MessageTable<T>::onMessage(unsigned int code, R (C::*func)(const Message&))
+{
+	GameObjectManager::getSingleton()._setMessageHandler(GameObjectManager::getTypeIndex<T>(), 
+		code, new CodeMessageHandler<T, C, R>(func));
+	return *this;
 }
 //--------------------------------------------------------------------------------------
 template<typename T>
 GameObject* GameObjectManager::createObject(Ogre::Vector3 pos, Ogre::Quaternion rot, 
 	PropertyList properties, Ogre::String name)
 {
-	//Calculate ID to assign. Just search for an unused ID.
-        ID id = 0;
-        for (; mGameObjectMap.find(id) != mGameObjectMap.end(); ++id);
+	//From a parallel tick, the GameObject is created after the parallel part.
+	if (mParallelPhase && _deferCreate(CreateFunction(this, &GameObjectManager::createObject<T>), 
+				pos, rot, properties, name))
+		return NULL;
 
-        return _createObject<T>(id, pos, rot, properties, name);
+	return _createObject<T>(_nextFreeID(), pos, rot, properties, name);
 }
 //--------------------------------------------------------------------------------------
 template<typename T>
@@ -524,61 +2222,177 @@ GameObject* GameObjectManager::_createObject(ID id, Ogre::Vector3 pos, Ogre::Qua
 	//No name.
 	name = ((name == "noname" ) ? "" : name);
 
+	//Check if ID is already used, or being given to a GameObject under construction.
+	unsigned int index = getIDIndex(id);
+	if (index < mSlots.size() && (mSlots[index].obj || mSlots[index].reserved))
+	{
+		OGRE_EXCEPT(Ogre::Exception::ERR_DUPLICATE_ITEM, "GameObject with ID " 
+			+ Ogre::StringConverter::toString(id) + " already exists!", "NGF::GameObjectManager::createObject()");
+	}
+
 	//Check if name is already used.
-	if (name != "")
+	if (name != "" && mNameMap.find(name) != mNameMap.end())
 	{
-		std::map<ID,GameObject*>::iterator objIter;
+		OGRE_EXCEPT(Ogre::Exception::ERR_DUPLICATE_ITEM, "GameObject with name'" 
+			+ name + "' already exists!", "NGF::GameObjectManager::createObject()");
+	}
+
+	//Take the slot before any constructor runs.
+	_reserveSlot(id);
+
+	unsigned int typeIndex = getTypeIndex<T>();
+	NGF_PROFILE(typeIndex, PROFILE_CREATE);
+	T *obj = NULL;
+
+	try
+	{
+		//Use a kept GameObject if the type recycles.
+		if (GameObject *kept = _reuseObject(typeIndex, id, pos, rot, properties, name))
+		{
+			return kept;
+		}
 
-		for (objIter = mGameObjectMap.begin();
-				   objIter != mGameObjectMap.end(); ++objIter)
+		//Create object, in the pool if the type has one.
+		if (void *mem = _allocateObject(typeIndex, sizeof(T)))
 		{
-			GameObject *obj = objIter->second;
-			if (obj->getName() == name)
+			try
+			{
+				obj = new (mem) T(pos, rot, id, properties, name);
+			}
+			catch (...)
 			{
-				OGRE_EXCEPT(Ogre::Exception::ERR_DUPLICATE_ITEM, "GameObject with name'" 
-					+ name + "' already exists!", "NGF::GameObjectManager::createObject()");
+				_deallocateObject(typeIndex, mem);
+				throw;
 			}
+			obj->mPooled = true;
+			NGF_PROFILE_ALLOCATION(typeIndex, sizeof(T), true);
 		}
-	}
-
-	//Create object.
-	T *obj = new T(pos, rot, id, properties, name);
+		else
+		{
+			obj = new T(pos, rot, id, properties, name);
+			NGF_PROFILE_ALLOCATION(typeIndex, sizeof(T), false);
+		}
+		obj->mTypeIndex = typeIndex;
 
-	//Check if name and ID was correctly passed.
-	if ((obj->getID() != id) || (obj->getName() != name))
+		//Check if name and ID was correctly passed.
+		if ((obj->getID() != id) || (obj->getName() != name))
+		{
+			OGRE_EXCEPT(Ogre::Exception::ERR_ITEM_NOT_FOUND, "Incorrect name or ID passed for GameObject with ID: " 
+				+ Ogre::StringConverter::toString(obj->getID()) + ", and name: '" + obj->getName() 
+				+ "'.", "NGF::GameObjectManager::createObject()");
+		}
+	}
+	catch (...)
 	{
-		OGRE_EXCEPT(Ogre::Exception::ERR_ITEM_NOT_FOUND, "Incorrect name or ID passed for GameObject with ID: " 
-			+ Ogre::StringConverter::toString(obj->getID()) + ", and name: '" + obj->getName() 
-			+ "'.", "NGF::GameObjectManager::createObject()");
+		if (obj)
+		{
+			_forgetObject(obj);
+			obj->destroy();
+			_freeObject(obj);
+		}
+		_releaseSlot(index);
+		throw;
 	}
 
-	//Put in map.
-	mGameObjectMap.insert(std::pair<ID,GameObject*>(id, obj));
+	//Put in slot.
+	_insertObject(obj, pos, rot);
 
 	return obj;
 }
 //--------------------------------------------------------------------------------------
 template<typename ReturnType>
-ReturnType GameObjectManager::sendMessageWithReply(GameObject *obj, Message msg)
+ReturnType GameObjectManager::sendMessageWithReply(GameObject *obj, const Message &msg)
 {
+	if (mParallelPhase && _getCommandBuffer())
+		OGRE_EXCEPT(Ogre::Exception::ERR_INVALID_STATE, "Can't wait for a reply in a parallel tick!", 
+			"NGF::GameObjectManager::sendMessageWithReply()");
+
 	if (obj)
 	{
-		boost::any reply = obj->receiveMessage(msg);
+		return _castReply<ReturnType>(_dispatchMessage(obj, msg));
+	}
+	OGRE_EXCEPT(Ogre::Exception::ERR_ITEM_NOT_FOUND, "GameObject doesn't exist!", "NGF::GameObjectManager::sendMessageWithReply()");
+}
+//--------------------------------------------------------------------------------------
+template<typename ReturnType, typename M>
+ReturnType GameObjectManager::sendMessageWithReply(GameObject *obj, const TypedMessage<M> &msg)
+{
+	if (mParallelPhase && _getCommandBuffer())
+		OGRE_EXCEPT(Ogre::Exception::ERR_INVALID_STATE, "Can't wait for a reply in a parallel tick!", 
+			"NGF::GameObjectManager::sendMessageWithReply()");
 
-		if (reply.empty())
-			OGRE_EXCEPT(Ogre::Exception::ERR_INVALID_STATE, "No reply!", "NGF::GameObjectManager::sendMessageWithReply()");
+	if (obj)
+	{
+		const M &typed = static_cast<const M&>(msg);
+		NGF_PROFILE(obj, PROFILE_MESSAGE);
 
-		try
-		{
-			return boost::any_cast<ReturnType>(reply);
-		}
-		catch (boost::bad_any_cast)
+		if (MessageHandler *handler = _getMessageHandler(obj, M::getCode()))
+			return _castReply<ReturnType>(handler->handleTyped(obj, &typed));
+		return _castReply<ReturnType>(obj->receiveMessage((Message(M::getCode()), typed)));
+	}
+	OGRE_EXCEPT(Ogre::Exception::ERR_ITEM_NOT_FOUND, "GameObject doesn't exist!", "NGF::GameObjectManager::sendMessageWithReply()");
+}
+//--------------------------------------------------------------------------------------
+template<typename M>
+void GameObjectManager::sendMessage(GameObject *obj, const TypedMessage<M> &msg) const
+{
+	if (obj)
+	{
+		const M &typed = static_cast<const M&>(msg);
+
+		//From a parallel tick, it's recorded as a Message.
+		if (mParallelPhase && _getCommandBuffer())
 		{
-			OGRE_EXCEPT(Ogre::Exception::ERR_INVALID_STATE, "Bad ReturnType!", "NGF::GameObjectManager::sendMessageWithReply()");
+			sendMessage(obj, (Message(M::getCode()), typed));
+			return;
 		}
 
+		NGF_PROFILE(obj, PROFILE_MESSAGE);
+		if (MessageHandler *handler = _getMessageHandler(obj, M::getCode()))
+			handler->handleTyped(obj, &typed);
+		else
+			obj->receiveMessage((Message(M::getCode()), typed));
 	}
-	OGRE_EXCEPT(Ogre::Exception::ERR_ITEM_NOT_FOUND, "GameObject doesn't exist!", "NGF::GameObjectManager::sendMessageWithReply()");
+}
+//--------------------------------------------------------------------------------------
+template<typename ReturnType>
+ReturnType GameObjectManager::_castReply(const MessageReply &reply)
+{
+	if (reply.empty())
+		OGRE_EXCEPT(Ogre::Exception::ERR_INVALID_STATE, "No reply!", "NGF::GameObjectManager::sendMessageWithReply()");
+
+	boost::optional<ReturnType> val = reply.find<ReturnType>();
+	if (!val)
+		OGRE_EXCEPT(Ogre::Exception::ERR_INVALID_STATE, "Bad ReturnType!", "NGF::GameObjectManager::sendMessageWithReply()");
+
+	return *val;
+}
+//--------------------------------------------------------------------------------------
+template<typename ReturnType>
+Reply<ReturnType> GameObjectManager::trySendMessageWithReply(GameObject *obj, const Message &msg)
+{
+	if (!obj)
+		return Reply<ReturnType>::failed(REPLY_NO_OBJECT);
+	if (mParallelPhase && _getCommandBuffer())
+		return Reply<ReturnType>::failed(REPLY_IN_PARALLEL);
+
+	return _toReply<ReturnType>(_dispatchMessage(obj, msg));
+}
+//--------------------------------------------------------------------------------------
+template<typename ReturnType, typename M>
+Reply<ReturnType> GameObjectManager::trySendMessageWithReply(GameObject *obj, const TypedMessage<M> &msg)
+{
+	if (!obj)
+		return Reply<ReturnType>::failed(REPLY_NO_OBJECT);
+	if (mParallelPhase && _getCommandBuffer())
+		return Reply<ReturnType>::failed(REPLY_IN_PARALLEL);
+
+	const M &typed = static_cast<const M&>(msg);
+	NGF_PROFILE(obj, PROFILE_MESSAGE);
+
+	if (MessageHandler *handler = _getMessageHandler(obj, M::getCode()))
+		return _toReply<ReturnType>(handler->handleTyped(obj, &typed));
+	return _toReply<ReturnType>(obj->receiveMessage((Message(M::getCode()), typed)));
 }
 
 } //namespace NGF
@@ -24,41 +24,136 @@
 
 namespace NGF { namespace Extras {
 
+//Runs tasks (any function taking nothing) after a while, on the GameObjectManager's task
+//wheel (see GameObjectManager::scheduleTask). Tasks are cancelled when the GameObject is
+//destroyed.
 class TaskManagingGameObject : virtual public GameObject
 {
     protected:
         typedef boost::function<void ()> Task;
 
-        typedef std::multimap<Ogre::Real, Task> TaskMap;
-        typedef std::pair<Ogre::Real, Task> TaskPair;
+        //Pending tasks by the index of their handle. 'order' is how many tasks were added
+        //before, which is how saved tasks are matched up on loading (see NGF_SERIALISE_TASKS).
+        struct PendingTask
+        {
+            TaskHandle handle;
+            unsigned int order;
+            Task task;
+        };
+        typedef std::map<unsigned int, PendingTask> TaskMap;
         TaskMap mTasks;
 
-        Ogre::Real mCurrTime;
+        unsigned int mTasksAdded;
         unsigned int mTasksDone;
 
+        void _runTask(TaskHandle handle)
+        {
+            TaskMap::iterator iter = mTasks.find(handle.index);
+            if (iter == mTasks.end() || iter->second.handle.generation != handle.generation)
+                return;
+
+            Task task = iter->second.task;
+            mTasks.erase(iter);
+            ++mTasksDone;
+            task();
+        }
+
+        TaskHandle _scheduleTask(Ogre::Real time, const Task &task, unsigned int order)
+        {
+            TaskHandle handle = GameObjectManager::getSingleton().scheduleTask(time, 
+                    fastdelegate::MakeDelegate(this, &TaskManagingGameObject::_runTask), this);
+
+            PendingTask &pending = mTasks[handle.index];
+            pending.handle = handle;
+            pending.order = order;
+            pending.task = task;
+            return handle;
+        }
+
     public:
         TaskManagingGameObject()
             : GameObject(Ogre::Vector3(), Ogre::Quaternion(), ID(), PropertyList(), ""),
-              mCurrTime(0),
+              mTasksAdded(0),
               mTasksDone(0)
         {
         }
 
-        void addTask(Ogre::Real time, Task task)
+        virtual ~TaskManagingGameObject()
+        {
+            GameObjectManager *mgr = GameObjectManager::getSingletonPtr();
+            if (mgr)
+                mgr->cancelTasks(this);
+        }
+
+        TaskHandle addTask(Ogre::Real time, Task task)
         {
-            mTasks.insert(TaskPair(mCurrTime + time, task));
+            return _scheduleTask(time, task, mTasksAdded++);
         }
 
-        void updateTasks(Ogre::Real deltaTime)
+        bool cancelTask(const TaskHandle &handle)
         {
-            mCurrTime += deltaTime;
+            TaskMap::iterator iter = mTasks.find(handle.index);
+            if (iter != mTasks.end() && iter->second.handle.generation == handle.generation)
+                mTasks.erase(iter);
 
-            for (TaskMap::iterator iter = mTasks.begin(); 
-                    iter != mTasks.end() && iter->first < mCurrTime;)
+            return GameObjectManager::getSingleton().cancelTask(handle);
+        }
+
+        //Tasks are run by the GameObjectManager now, so this does nothing. Kept so older
+        //GameObjects still build.
+        void updateTasks(Ogre::Real)
+        {
+        }
+
+        //--- Internal stuff --------------------------------------------------------------
+
+        //The pending tasks as 'order timeLeft' pairs, for NGF_SERIALISE_TASKS.
+        Ogre::String _saveTasks() const
+        {
+            GameObjectManager &mgr = GameObjectManager::getSingleton();
+            Ogre::String str;
+
+            for (TaskMap::const_iterator iter = mTasks.begin(); iter != mTasks.end(); ++iter)
+            {
+                Ogre::Real left = mgr.getTaskTimeLeft(iter->second.handle);
+                if (left >= 0)
+                    str += Ogre::StringConverter::toString(iter->second.order) + " " 
+                        + Ogre::StringConverter::toString(left) + " ";
+            }
+
+            return str;
+        }
+
+        //The tasks added so far (by the constructor, when loading) get the time they had
+        //left when saved. Those that weren't pending then are dropped. Saves that only
+        //have 'mTasksDone' drop the first that many.
+        void _loadTasks(const Ogre::String &str, bool hasTasks)
+        {
+            std::map<unsigned int, Ogre::Real> saved;
+            std::vector<Ogre::String> words = Ogre::StringUtil::split(str);
+            for (unsigned int i = 0; i + 1 < words.size(); i += 2)
+                saved[Ogre::StringConverter::parseUnsignedInt(words[i])] 
+                    = Ogre::StringConverter::parseReal(words[i + 1]);
+
+            GameObjectManager &mgr = GameObjectManager::getSingleton();
+            TaskMap added;
+            added.swap(mTasks);
+
+            for (TaskMap::iterator iter = added.begin(); iter != added.end(); ++iter)
             {
-                iter->second();
-                mTasks.erase(iter++);
-                ++mTasksDone;
+                Ogre::Real left = mgr.getTaskTimeLeft(iter->second.handle);
+                if (!mgr.cancelTask(iter->second.handle))
+                    continue;
+
+                unsigned int order = iter->second.order;
+                if (hasTasks)
+                {
+                    std::map<unsigned int, Ogre::Real>::iterator found = saved.find(order);
+                    if (found != saved.end())
+                        _scheduleTask(found->second, iter->second.task, order);
+                }
+                else if (order >= mTasksDone)
+                    _scheduleTask(left, iter->second.task, order);
             }
         }
 };
@@ -285,6 +285,7 @@ namespace Util {
                                                                                                \
             if (mPythonEvents.has_key(NGF_name))                                               \
             {                                                                                  \
+                NGF_PROFILE_LABEL(this, NGF::PROFILE_PYTHON, NGF_name);                        \
             return (NGF::Python::PythonManager::getSingleton().getMainNamespace()["callFunc"]) \
                         (mPythonEvents, NGF_name, mConnector, args);                           \
             }
@@ -309,9 +310,15 @@ namespace Util {
         runString("del " #evt "\n")
 
 //To call a saved event. The event (function) receives a 'self' parameter, and whatever
-//other parameters are passed in.
+//other parameters are passed in. The profiler times it until the end of the expression.
+#ifdef NGF_ENABLE_PROFILER
+#define NGF_PY_CALL_EVENT(evt, ...)                                                            \
+        (NGF::ProfileScope(this, NGF::PROFILE_PYTHON, #evt),                                   \
+         mPythonEvents[#evt](mConnector, ##__VA_ARGS__))
+#else
 #define NGF_PY_CALL_EVENT(evt, ...)                                                            \
         mPythonEvents[#evt](mConnector, ##__VA_ARGS__)
+#endif
 
 //Used by 'ngfpydef', you don't usually have to use these yourself.
 #define NGF_PY_CLASS_GPERF(classnm) PythonHash_##classnm 
@@ -268,20 +268,17 @@ class GameObjectRecord
                 }                                                                              \
             }                                                                                      
 
-//Serialises tasks in a TaskManagingGameObject.
+//Serialises tasks in a TaskManagingGameObject. Only tasks added before loading (usually in
+//the constructor) can be restored, they are matched up with the saved ones by the order they
+//were added in.
 #define NGF_SERIALISE_TASKS()                                                                  \
-            NGF_SERIALISE_OGRE(Real, mCurrTime);                                               \
             NGF_SERIALISE_OGRE(UnsignedInt, mTasksDone);                                       \
                                                                                                \
-            /* Remove tasks that are already done. */                                          \
-            NGF_SERIALISE_ON_LOAD                                                              \
-            {                                                                                  \
-                unsigned int i = 0;                                                            \
-                for (TaskMap::iterator iter = mTasks.begin();                                  \
-                        iter != mTasks.end() && i < mTasksDone; ++i, ++iter)                   \
-                {                                                                              \
-                    mTasks.erase(iter);                                                        \
-                }                                                                              \
+            if (save) {                                                                        \
+                out.addProperty("NGF_TASKS", _saveTasks(), "");                                \
+            } else {                                                                           \
+                Ogre::String tasksStr = in.getValue("NGF_TASKS", 0, "n");                      \
+                _loadTasks(tasksStr, tasksStr != "n");                                         \
             }
 
 //Serialises an STL container, with boost-serialisable element types. You'll have to make sure
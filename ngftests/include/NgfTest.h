@@ -0,0 +1,92 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  NgfTest.h
+ *
+ *    Description:  A tiny harness for checking and timing NGF. Each test or benchmark
+ *                  gets a fresh GameObjectManager, and registers the types it needs.
+ *
+ *         Author:  Nikhilesh (nikki)
+ *
+ * =====================================================================================
+ */
+
+#ifndef __NGF_TEST_H__
+#define __NGF_TEST_H__
+
+#include "Ngf.h"
+#include "OgreTimer.h"
+
+#include <vector>
+#include <cstdio>
+
+//Define a test, or a benchmark (only run with '--bench'). The body runs with a new
+//GameObjectManager, deleted after it.
+#define NGF_TEST(name) \
+	static void name(); \
+	static NGFTest::Registration name##Registration(#name, &name, false); \
+	static void name()
+
+#define NGF_BENCH(name) \
+	static void name(); \
+	static NGFTest::Registration name##Registration(#name, &name, true); \
+	static void name()
+
+//Fail the test if 'expr' is false.
+#define NGF_CHECK(expr) \
+	do { if (!(expr)) throw NGFTest::Failure(__FILE__, __LINE__, #expr); } while (0)
+
+//The constructor every test GameObject needs.
+#define NGF_TEST_CONSTRUCTOR(type) \
+	type(Ogre::Vector3 pos, Ogre::Quaternion rot, NGF::ID id, NGF::PropertyList props, Ogre::String name) \
+	    : NGF::GameObject(pos, rot, id, props, name)
+
+namespace NGFTest {
+
+typedef void (*TestFunction)();
+
+struct Test
+{
+	const char *name;
+	TestFunction func;
+	bool bench;
+};
+
+std::vector<Test> &getTests();
+
+struct Registration
+{
+	Registration(const char *name, TestFunction func, bool bench)
+	{
+		Test test = { name, func, bench };
+		getTests().push_back(test);
+	}
+};
+
+struct Failure
+{
+	const char *file;
+	int line;
+	const char *expr;
+
+	Failure(const char *f, int l, const char *e) : file(f), line(l), expr(e) { }
+};
+
+//Frame events for ticking.
+inline Ogre::FrameEvent frameEvent(Ogre::Real time)
+{
+	Ogre::FrameEvent evt;
+	evt.timeSinceLastFrame = time;
+	evt.timeSinceLastEvent = time;
+	return evt;
+}
+
+//Print a benchmark result, in milliseconds.
+inline void report(const char *what, unsigned long micros)
+{
+	printf("    %-48s %10.3f ms\n", what, micros / 1000.0);
+}
+
+} //namespace NGFTest
+
+#endif
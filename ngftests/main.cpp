@@ -0,0 +1,80 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  main.cpp
+ *
+ *    Description:  Runs the NGF tests, or the benchmarks with '--bench'. Give names to
+ *                  run only those.
+ *
+ *         Author:  Nikhilesh (nikki)
+ *
+ * =====================================================================================
+ */
+
+#include "NgfTest.h"
+
+#include <cstring>
+
+std::vector<NGFTest::Test> &NGFTest::getTests()
+{
+	static std::vector<Test> tests;
+	return tests;
+}
+
+static bool wanted(const NGFTest::Test &test, bool bench, int argc, char **argv, int first)
+{
+	if (first == argc)
+	{
+		return test.bench == bench;
+	}
+
+	for (int i = first; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], test.name))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+int main(int argc, char **argv)
+{
+	bool bench = argc > 1 && !strcmp(argv[1], "--bench");
+	int first = bench ? 2 : 1;
+
+	std::vector<NGFTest::Test> &tests = NGFTest::getTests();
+	unsigned int numRun = 0, numFailed = 0;
+
+	for (unsigned int i = 0; i < tests.size(); ++i)
+	{
+		if (!wanted(tests[i], bench, argc, argv, first))
+		{
+			continue;
+		}
+
+		printf("%s\n", tests[i].name);
+		fflush(stdout);
+		++numRun;
+
+		NGF::GameObjectManager *mgr = new NGF::GameObjectManager();
+		try
+		{
+			tests[i].func();
+		}
+		catch (const NGFTest::Failure &f)
+		{
+			printf("    FAILED %s:%d: %s\n", f.file, f.line, f.expr);
+			++numFailed;
+		}
+		catch (const Ogre::Exception &e)
+		{
+			printf("    FAILED with exception: %s\n", e.getFullDescription().c_str());
+			++numFailed;
+		}
+		delete mgr;
+	}
+
+	printf("%u run, %u failed\n", numRun, numFailed);
+	return numFailed ? 1 : 0;
+}
@@ -0,0 +1,85 @@
+---------------------------------------------------------------------------------------------
+------------------------------- NGFTests 'Premake.lua' file ---------------------------------
+---------------------------------------------------------------------------------------------
+
+-- Run 'NGFTests' for the tests, 'NGFTests --bench' for the benchmarks. Build the Release
+-- configuration for benchmarking.
+
+-- Project ----------------------------------------------------------------------------------
+
+project.name = "NGFTests"
+project.bindir = "bin"
+
+-- Package ----------------------------------------------------------------------------------
+
+package = newpackage()
+
+package.name = "NGFTests"
+package.kind = "exe"
+package.language = "c++"
+package.configs = { "Debug", "Release" } -- If you add more, configure them at the bottom.
+
+if (windows) then
+   table.insert(package.defines, "WIN32") -- To fix a problem on Windows.
+end
+
+table.insert(package.defines, "NGF_ENABLE_PROFILER") -- For the profiler tests.
+
+-- Include and library search paths, system dependent (I don't assume a directory structure)
+
+package.includepaths = {
+-- Edit include directories here. Add the Ogre include directory if you don't use
+-- pkg-config
+"<boostdir>",                                                           -- Boost.
+
+-- You don't have to edit the directories below, they're relative.
+"../include",                                                           -- NGF.
+"include"                                                               -- NGFTests files.
+}
+
+package.libpaths = {
+-- Edit library directories here. Add the Ogre library directory if you don't use
+-- pkg-config
+}
+
+-- Libraries to link to ---------------------------------------------------------------------
+
+package.links = {
+-- Add the Ogre library here, if you don't use pkg-config.
+}
+
+-- pkg-configable stuff ---------------------------------------------------------------------
+
+if (linux) then
+    package.buildoptions = {
+    "`pkg-config OGRE --cflags`"
+    }
+
+    package.linkoptions = {
+    "`pkg-config OGRE --libs`"
+    }
+
+    table.insert(package.links, "boost_thread")                         -- NGF uses Boost.Thread.
+end
+
+-- Files ------------------------------------------------------------------------------------
+
+package.files = {
+matchrecursive("*.h", "*.cpp"),
+"../Ngf.cpp"
+}
+
+-- Debug configuration ----------------------------------------------------------------------
+
+debug = package.config["Debug"]
+debug.defines = { "DEBUG", "_DEBUG" }
+debug.objdir = "obj/debug"
+debug.target = "debug/" .. package.name .. "_d"
+
+debug.buildoptions = { "-g" }
+
+-- Release configuration --------------------------------------------------------------------
+
+release = package.config["Release"]
+release.objdir = "obj/release"
+release.target = "release/" .. package.name
@@ -0,0 +1,155 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  BudgetTests.cpp
+ *
+ *    Description:  The tick budget: what counts against it, and every priority getting
+ *                  its turn under overload.
+ *
+ *         Author:  Nikhilesh (nikki)
+ *
+ * =====================================================================================
+ */
+
+#include "NgfTest.h"
+
+using namespace NGF;
+
+namespace {
+
+void spin(unsigned long micros)
+{
+	Ogre::Timer timer;
+	while (timer.getMicroseconds() < micros)
+	{
+	}
+}
+
+//Takes a while to tick, and notes the frames it ticked in.
+struct Slow : public GameObject
+{
+	static unsigned int frame;
+	unsigned long micros;
+	std::vector<unsigned int> frames;
+
+	NGF_TEST_CONSTRUCTOR(Slow), micros(300) { setTickFlags(TICK_UNPAUSED); }
+
+	void unpausedTick(const Ogre::FrameEvent &) 
+	{ 
+		spin(micros); 
+		frames.push_back(frame);
+	}
+};
+unsigned int Slow::frame = 0;
+
+struct Fast : public GameObject
+{
+	unsigned int ticks;
+
+	NGF_TEST_CONSTRUCTOR(Fast), ticks(0) { setTickFlags(TICK_UNPAUSED); }
+
+	void unpausedTick(const Ogre::FrameEvent &) { ++ticks; }
+};
+
+struct Plain : public GameObject
+{
+	NGF_TEST_CONSTRUCTOR(Plain) { }
+};
+
+}
+
+//More high priority work than fits in the budget, every frame.
+NGF_TEST(budgetNoStarving)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	mgr.setTickBudget(0.001f);
+
+	std::vector<Slow *> high, low;
+	for (unsigned int i = 0; i < 20; ++i)
+	{
+		high.push_back((Slow *) mgr.createObject<Slow>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY));
+		high.back()->setDeferrableTick(true, 5);
+	}
+	for (unsigned int i = 0; i < 3; ++i)
+	{
+		low.push_back((Slow *) mgr.createObject<Slow>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY));
+		low.back()->setDeferrableTick(true, 0);
+	}
+
+	const unsigned int numFrames = 30;
+	for (Slow::frame = 0; Slow::frame < numFrames; ++Slow::frame)
+	{
+		mgr.tick(false, NGFTest::frameEvent(0.1f));
+	}
+	NGF_CHECK(mgr.getTickBudgetTotals().numFramesDeferred == numFrames);
+
+	//Each low priority GameObject waits at most as many frames as there are of them.
+	for (unsigned int i = 0; i < low.size(); ++i)
+	{
+		std::vector<unsigned int> &frames = low[i]->frames;
+		NGF_CHECK(!frames.empty() && frames.front() < low.size());
+		for (unsigned int f = 1; f < frames.size(); ++f)
+		{
+			NGF_CHECK(frames[f] - frames[f - 1] <= low.size());
+		}
+		NGF_CHECK(numFrames - 1 - frames.back() < low.size());
+	}
+
+	//The high priority ones still get the lion's share.
+	unsigned int highTicks = 0, lowTicks = 0;
+	for (unsigned int i = 0; i < high.size(); ++i)
+	{
+		highTicks += high[i]->frames.size();
+	}
+	for (unsigned int i = 0; i < low.size(); ++i)
+	{
+		lowTicks += low[i]->frames.size();
+	}
+	NGF_CHECK(highTicks > lowTicks);
+}
+
+//Slow ticks that can't be put off don't use up the budget.
+NGF_TEST(budgetOnlyDeferrable)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	mgr.setTickBudget(0.002f);
+
+	Slow *busy = (Slow *) mgr.createObject<Slow>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+	busy->micros = 5000;
+
+	std::vector<Fast *> fast;
+	for (unsigned int i = 0; i < 10; ++i)
+	{
+		fast.push_back((Fast *) mgr.createObject<Fast>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY));
+		fast.back()->setDeferrableTick(true);
+	}
+
+	for (unsigned int frame = 0; frame < 5; ++frame)
+	{
+		mgr.tick(false, NGFTest::frameEvent(0.1f));
+	}
+	for (unsigned int i = 0; i < fast.size(); ++i)
+	{
+		NGF_CHECK(fast[i]->ticks == 5);
+	}
+	NGF_CHECK(mgr.getTickBudgetTotals().numDeferred == 0);
+}
+
+NGF_TEST(budgetNotParallel)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+
+	bool threw = false;
+	try
+	{
+		mgr.setTypeOptions<Plain>(TypeOptions().deferrable().parallel());
+	}
+	catch (Ogre::Exception &)
+	{
+		threw = true;
+	}
+	NGF_CHECK(threw);
+
+	//Deferrable with an interval is fine, it is for the paused ticks.
+	mgr.setTypeOptions<Plain>(TypeOptions().deferrable().interval(2));
+}
@@ -0,0 +1,187 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  ChannelTests.cpp
+ *
+ *    Description:  Event channels: subscribing, unsubscribing, and subscriptions ending
+ *                  with their GameObjects, including ones whose creation failed.
+ *
+ *         Author:  Nikhilesh (nikki)
+ *
+ * =====================================================================================
+ */
+
+#include "NgfTest.h"
+
+using namespace NGF;
+
+namespace {
+
+//Counts the messages it gets.
+struct Listener : public GameObject
+{
+	unsigned int heard;
+
+	NGF_TEST_CONSTRUCTOR(Listener), heard(0) { }
+
+	MessageReply receiveMessage(const Message &msg)
+	{
+		++heard;
+		return MessageReply();
+	}
+};
+
+//Subscribes and then fails.
+struct FailsSubscribed : public GameObject
+{
+	NGF_TEST_CONSTRUCTOR(FailsSubscribed)
+	{
+		GameObjectManager::getSingleton().subscribe(this, "news");
+		OGRE_EXCEPT(Ogre::Exception::ERR_INVALIDPARAMS, "Failing on purpose", "FailsSubscribed::FailsSubscribed()");
+	}
+};
+
+//Subscribes, but passes on the wrong name, so the manager fails it once it's constructed.
+struct SubscribedWrongName : public GameObject
+{
+	SubscribedWrongName(Ogre::Vector3 pos, Ogre::Quaternion rot, ID id, PropertyList props, Ogre::String name)
+	    : GameObject(pos, rot, id, props, "wrong")
+	{
+		GameObjectManager::getSingleton().subscribe(this, "news");
+	}
+};
+
+//Recycled, subscribes again when reused and fails if asked to.
+struct Resubscribes : public GameObject
+{
+	static bool fail;
+
+	NGF_TEST_CONSTRUCTOR(Resubscribes)
+	{
+		GameObjectManager::getSingleton().subscribe(this, "news");
+	}
+
+	void reactivate(Ogre::Vector3 pos, Ogre::Quaternion rot, PropertyList properties)
+	{
+		GameObjectManager::getSingleton().subscribe(this, "news");
+		if (fail)
+		{
+			OGRE_EXCEPT(Ogre::Exception::ERR_INVALIDPARAMS, "Failing on purpose", "Resubscribes::reactivate()");
+		}
+	}
+};
+bool Resubscribes::fail = false;
+
+unsigned int countSubscribers(const Ogre::String &channel)
+{
+	GameObjectManager::ObjectRange range = GameObjectManager::getSingleton().getSubscribers(channel);
+	return range.second - range.first;
+}
+
+}
+
+NGF_TEST(channelSubscriptions)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	Listener *a = (Listener *) mgr.createObject<Listener>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+	Listener *b = (Listener *) mgr.createObject<Listener>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+	Listener *c = (Listener *) mgr.createObject<Listener>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+
+	NGF_CHECK(countSubscribers("news") == 0);
+	NGF_CHECK(mgr.publish("news", Message("hello")) == 0);
+
+	Subscription subA = mgr.subscribe(a, "news");
+	Subscription subB = mgr.subscribe(b, mgr.getChannel("news"));
+	Subscription subC = mgr.subscribe(c, "news");
+	mgr.subscribe(c, "weather");
+	NGF_CHECK(mgr.getChannel("news") == mgr.getChannel("news"));
+	NGF_CHECK(mgr.getChannel("news") != mgr.getChannel("weather"));
+
+	//Subscribing again gives the same subscription.
+	Subscription again = mgr.subscribe(a, "news");
+	NGF_CHECK(again.index == subA.index && again.generation == subA.generation);
+	NGF_CHECK(countSubscribers("news") == 3);
+
+	NGF_CHECK(mgr.publish("news", Message("hello")) == 3);
+	NGF_CHECK(a->heard == 1 && b->heard == 1 && c->heard == 1);
+
+	NGF_CHECK(mgr.unsubscribe(subA));
+	NGF_CHECK(!mgr.unsubscribe(subA));
+	NGF_CHECK(!mgr.isSubscribed(subA) && mgr.isSubscribed(subB));
+	NGF_CHECK(mgr.publish("news", Message("hello")) == 2);
+	NGF_CHECK(a->heard == 1 && b->heard == 2 && c->heard == 2);
+
+	//Destroying ends all its subscriptions, and the handles stay stale once their slots
+	//are reused.
+	mgr.destroyObject(c->getID());
+	NGF_CHECK(!mgr.isSubscribed(subC));
+	NGF_CHECK(countSubscribers("news") == 1 && countSubscribers("weather") == 0);
+	Subscription reused = mgr.subscribe(a, "weather");
+	NGF_CHECK(mgr.isSubscribed(reused) && !mgr.isSubscribed(subC));
+
+	//Posting goes through the same subscribers, a frame later.
+	NGF_CHECK(mgr.publishQueued("news", Message("later")) == 1);
+	NGF_CHECK(b->heard == 2);
+	mgr.tick(false, NGFTest::frameEvent(0.016f));
+	NGF_CHECK(b->heard == 3);
+
+	mgr.destroyAll();
+	NGF_CHECK(!mgr.isSubscribed(subB) && !mgr.isSubscribed(reused));
+	NGF_CHECK(countSubscribers("news") == 0 && countSubscribers("weather") == 0);
+}
+
+NGF_TEST(channelFailedCreation)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	Listener *live = (Listener *) mgr.createObject<Listener>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+	mgr.subscribe(live, "news");
+
+	//Failing in the constructor.
+	bool thrown = false;
+	try
+	{
+		mgr.createObject<FailsSubscribed>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+	}
+	catch (Ogre::Exception &)
+	{
+		thrown = true;
+	}
+	NGF_CHECK(thrown);
+	NGF_CHECK(countSubscribers("news") == 1);
+
+	//Failing once constructed.
+	thrown = false;
+	try
+	{
+		mgr.createObject<SubscribedWrongName>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+	}
+	catch (Ogre::Exception &)
+	{
+		thrown = true;
+	}
+	NGF_CHECK(thrown);
+	NGF_CHECK(countSubscribers("news") == 1);
+
+	//Failing when reused.
+	mgr.setTypeOptions<Resubscribes>(TypeOptions().recycle(4));
+	Resubscribes::fail = false;
+	mgr.destroyObject(mgr.createObject<Resubscribes>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY)->getID());
+	NGF_CHECK(countSubscribers("news") == 1);
+	Resubscribes::fail = true;
+	thrown = false;
+	try
+	{
+		mgr.createObject<Resubscribes>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+	}
+	catch (Ogre::Exception &)
+	{
+		thrown = true;
+	}
+	NGF_CHECK(thrown);
+	NGF_CHECK(countSubscribers("news") == 1);
+
+	//Nothing left behind for the channel to send to.
+	NGF_CHECK(mgr.publish("news", Message("hello")) == 1);
+	NGF_CHECK(live->heard == 1);
+	NGF_CHECK(mgr.getNumObjects() == 1);
+}
@@ -0,0 +1,157 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  GroupMessageTests.cpp
+ *
+ *    Description:  Sending and posting one message to a flag or type group: who gets
+ *                  it, and the counts returned.
+ *
+ *         Author:  Nikhilesh (nikki)
+ *
+ * =====================================================================================
+ */
+
+#include "NgfTest.h"
+
+using namespace NGF;
+
+namespace {
+
+struct MsgAlarm : public TypedMessage<MsgAlarm>
+{
+	int level;
+	MsgAlarm(int l) : level(l) { }
+};
+
+//Gets alarms through a handler. One of them destroys another and brings in a Medic
+//when it hears one.
+struct Soldier : public GameObject
+{
+	static ID victim;
+	int alarms;
+	bool saboteur;
+
+	NGF_TEST_CONSTRUCTOR(Soldier), alarms(0), saboteur(false) { addFlag("enemy"); }
+
+	void alarm(const MsgAlarm &msg)
+	{
+		alarms += msg.level;
+		if (saboteur)
+		{
+			GameObjectManager &mgr = GameObjectManager::getSingleton();
+			mgr.destroyObject(victim);
+			mgr.createObject("Medic", Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+		}
+	}
+};
+ID Soldier::victim = 0;
+
+//Gets them in 'receiveMessage'.
+struct Medic : public GameObject
+{
+	int alarms;
+
+	NGF_TEST_CONSTRUCTOR(Medic), alarms(0) { addFlag("enemy"); }
+
+	MessageReply receiveMessage(const Message &msg)
+	{
+		if (msg.code == MsgAlarm::getCode())
+		{
+			alarms += msg.getParam<MsgAlarm>(0).level;
+		}
+		NGF_NO_REPLY();
+	}
+};
+
+void registerTypes()
+{
+	GameObjectFactory::getSingleton().registerObjectType<Soldier>("Soldier").onMessage<MsgAlarm>(&Soldier::alarm);
+	NGF_REGISTER_OBJECT_TYPE(Medic);
+}
+
+template<typename T>
+std::vector<T*> create(unsigned int num, const Ogre::String &type)
+{
+	std::vector<T*> objs;
+	for (unsigned int i = 0; i < num; ++i)
+	{
+		objs.push_back((T *) GameObjectManager::getSingleton().createObject(type, Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY));
+	}
+	return objs;
+}
+
+template<typename T>
+int totalAlarms(const std::vector<T*> &objs)
+{
+	int total = 0;
+	for (unsigned int i = 0; i < objs.size(); ++i)
+	{
+		total += objs[i]->alarms;
+	}
+	return total;
+}
+
+}
+
+NGF_TEST(groupSendCounts)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	registerTypes();
+	std::vector<Soldier*> soldiers = create<Soldier>(10, "Soldier");
+	std::vector<Medic*> medics = create<Medic>(5, "Medic");
+
+	NGF_CHECK(mgr.sendMessageToGroup(mgr.getObjectsWithFlag("enemy"), MsgAlarm(1)) == 15);
+	NGF_CHECK(totalAlarms(soldiers) == 10 && totalAlarms(medics) == 5);
+	NGF_CHECK(mgr.sendMessageToGroup(mgr.getObjectsOfType<Soldier>(), MsgAlarm(2)) == 10);
+	NGF_CHECK(mgr.sendMessageToGroup(mgr.getObjectsOfType("Medic"), (Message(MsgAlarm::getCode()), MsgAlarm(3))) == 5);
+	NGF_CHECK(totalAlarms(soldiers) == 30 && totalAlarms(medics) == 20);
+	NGF_CHECK(mgr.sendMessageToGroup(mgr.getObjectsWithFlag("friend"), MsgAlarm(1)) == 0);
+
+	//One destroyed before its turn is skipped, and one joining on the way doesn't get it.
+	GameObjectManager::ObjectRange group = mgr.getObjectsOfType<Soldier>();
+	Soldier *first = (Soldier *) *group.first;
+	Soldier *last = (Soldier *) *(group.second - 1);
+	first->saboteur = true;
+	Soldier::victim = last->getID();
+	NGF_CHECK(mgr.sendMessageToGroup(mgr.getObjectsWithFlag("enemy"), MsgAlarm(1)) == 14);
+	NGF_CHECK(mgr.getNumObjects() == 15);
+	first->saboteur = false;
+
+	GameObjectManager::ObjectRange newMedics = mgr.getObjectsOfType<Medic>();
+	NGF_CHECK(newMedics.second - newMedics.first == 6);
+	for (GameObjectManager::ObjectIterator iter = newMedics.first; iter != newMedics.second; ++iter)
+	{
+		NGF_CHECK(((Medic *) *iter)->alarms == 0 || ((Medic *) *iter)->alarms == 5);
+	}
+}
+
+NGF_TEST(groupPostCounts)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	registerTypes();
+	std::vector<Soldier*> soldiers = create<Soldier>(10, "Soldier");
+	std::vector<Medic*> medics = create<Medic>(5, "Medic");
+
+	//Delivered on the tick.
+	NGF_CHECK(mgr.postMessageToGroup(mgr.getObjectsWithFlag("enemy"), MsgAlarm(1)) == 15);
+	NGF_CHECK(mgr.getNumPostedMessages() == 15);
+	NGF_CHECK(totalAlarms(soldiers) == 0 && totalAlarms(medics) == 0);
+	mgr.tick(false, NGFTest::frameEvent(0.016f));
+	NGF_CHECK(totalAlarms(soldiers) == 10 && totalAlarms(medics) == 5);
+	NGF_CHECK(mgr.getMessageQueueStats().numPosted == 15 && mgr.getMessageQueueStats().numDelivered == 15);
+
+	//All or nothing when the queue is short of room.
+	mgr.setMessageQueueCapacity(12);
+	NGF_CHECK(mgr.postMessageToGroup(mgr.getObjectsWithFlag("enemy"), MsgAlarm(1)) == 0);
+	NGF_CHECK(mgr.getNumPostedMessages() == 0);
+	NGF_CHECK(mgr.postMessageToGroup(mgr.getObjectsOfType<Soldier>(), MsgAlarm(1)) == 10);
+	NGF_CHECK(mgr.postMessageToGroup(mgr.getObjectsOfType<Medic>(), MsgAlarm(1)) == 0);
+	NGF_CHECK(mgr.getNumPostedMessages() == 10);
+
+	//Those gone by delivery don't get it.
+	mgr.destroyObject(soldiers[0]->getID());
+	mgr.tick(false, NGFTest::frameEvent(0.016f));
+	NGF_CHECK(mgr.getMessageQueueStats().numDelivered == 9 && mgr.getMessageQueueStats().numStale == 1);
+	NGF_CHECK(soldiers[1]->alarms == 2 && totalAlarms(medics) == 5);
+	NGF_CHECK(mgr.postMessageToGroup(mgr.getObjectsWithFlag("friend"), MsgAlarm(1)) == 0);
+}
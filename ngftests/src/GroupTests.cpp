@@ -0,0 +1,150 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  GroupTests.cpp
+ *
+ *    Description:  The flag and type indices: kept right as GameObjects join and leave
+ *                  groups, including while going through a copy of a group.
+ *
+ *         Author:  Nikhilesh (nikki)
+ *
+ * =====================================================================================
+ */
+
+#include "NgfTest.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <set>
+
+using namespace NGF;
+
+namespace {
+
+struct Ant : public GameObject
+{
+	NGF_TEST_CONSTRUCTOR(Ant) { }
+};
+
+//Red from the start.
+struct Beetle : public GameObject
+{
+	NGF_TEST_CONSTRUCTOR(Beetle) { addFlag("red"); }
+};
+
+std::vector<GameObject*> copy(const GameObjectManager::ObjectRange &range)
+{
+	return std::vector<GameObject*>(range.first, range.second);
+}
+
+//Checks the groups against every live GameObject in 'ids'.
+void checkGroups(const std::vector<ID> &ids)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	const char *flags[] = { "red", "blue", "green" };
+
+	for (unsigned int f = 0; f < 3; ++f)
+	{
+		std::vector<GameObject*> members = copy(mgr.getObjectsWithFlag(flags[f]));
+		std::set<GameObject*> unique(members.begin(), members.end());
+		NGF_CHECK(unique.size() == members.size());
+
+		unsigned int expected = 0;
+		for (unsigned int i = 0; i < ids.size(); ++i)
+		{
+			GameObject *obj = mgr.getByID(ids[i]);
+			if (obj && obj->hasFlag(flags[f]))
+			{
+				NGF_CHECK(unique.count(obj) == 1);
+				++expected;
+			}
+		}
+		NGF_CHECK(members.size() == expected);
+	}
+
+	GameObjectManager::ObjectRange ants = mgr.getObjectsOfType<Ant>(), beetles = mgr.getObjectsOfType<Beetle>();
+	NGF_CHECK((unsigned int) ((ants.second - ants.first) + (beetles.second - beetles.first)) == mgr.getNumObjects());
+	for (GameObjectManager::ObjectIterator iter = ants.first; iter != ants.second; ++iter)
+	{
+		NGF_CHECK(dynamic_cast<Ant *>(*iter) && mgr.getByID((*iter)->getID()) == *iter);
+	}
+}
+
+}
+
+NGF_TEST(groupsWhileIterating)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	NGF_REGISTER_OBJECT_TYPE(Ant);
+	NGF_REGISTER_OBJECT_TYPE(Beetle);
+
+	std::srand(13);
+	std::vector<ID> ids;
+	for (unsigned int i = 0; i < 300; ++i)
+	{
+		GameObject *obj = mgr.createObject<Ant>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+		if (std::rand() % 2)
+		{
+			obj->addFlag("red");
+		}
+		if (std::rand() % 3)
+		{
+			obj->addFlag("blue");
+		}
+		ids.push_back(obj->getID());
+	}
+	checkGroups(ids);
+
+	//Going through the reds, changing flags, destroying and creating.
+	std::vector<GameObject*> reds = copy(mgr.getObjectsWithFlag("red"));
+	unsigned int numRed = reds.size();
+	for (unsigned int i = 0; i < reds.size(); ++i)
+	{
+		GameObject *obj = reds[i];
+		NGF_CHECK(obj->removeFlag("red"));
+		NGF_CHECK(!obj->removeFlag("red"));
+		obj->addFlag("green")->addFlag("green");
+
+		switch (i % 4)
+		{
+		case 0:
+			mgr.destroyObject(obj->getID());
+			break;
+		case 1:
+			ids.push_back(mgr.createObject<Beetle>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY)->getID());
+			break;
+		case 2:
+			obj->removeFlag("blue");
+			break;
+		}
+	}
+	checkGroups(ids);
+
+	//Only the Beetles are red now.
+	GameObjectManager::ObjectRange red = mgr.getObjectsWithFlag("red");
+	NGF_CHECK((unsigned int) (red.second - red.first) == (numRed + 2) / 4);
+	for (GameObjectManager::ObjectIterator iter = red.first; iter != red.second; ++iter)
+	{
+		NGF_CHECK(dynamic_cast<Beetle *>(*iter));
+	}
+
+	//Going through the Ants, destroying some and flagging the rest.
+	std::vector<GameObject*> ants = copy(mgr.getObjectsOfType<Ant>());
+	for (unsigned int i = 0; i < ants.size(); ++i)
+	{
+		if (i % 3 == 0)
+		{
+			mgr.destroyObject(ants[i]->getID());
+		}
+		else
+		{
+			ants[i]->addFlag("red");
+		}
+	}
+	checkGroups(ids);
+
+	mgr.destroyAll();
+	checkGroups(ids);
+	NGF_CHECK(mgr.getObjectsWithFlag("green").first == mgr.getObjectsWithFlag("green").second);
+	NGF_CHECK(mgr.getObjectsOfType("Beetle").first == mgr.getObjectsOfType("Beetle").second);
+}
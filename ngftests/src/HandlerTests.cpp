@@ -0,0 +1,103 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  HandlerTests.cpp
+ *
+ *    Description:  Message handler tables: messages going to a type's handlers instead
+ *                  of 'receiveMessage', typed or by name or code.
+ *
+ *         Author:  Nikhilesh (nikki)
+ *
+ * =====================================================================================
+ */
+
+#include "NgfTest.h"
+
+using namespace NGF;
+
+namespace {
+
+struct MsgHit : public TypedMessage<MsgHit>
+{
+	int damage;
+	MsgHit(int d) : damage(d) { }
+};
+
+struct MsgGetHealth : public TypedMessage<MsgGetHealth> { };
+
+struct MsgWave : public TypedMessage<MsgWave>
+{
+	int times;
+	MsgWave(int t) : times(t) { }
+};
+
+struct Player : public GameObject
+{
+	int health;
+	int jumps;
+	int fallbacks;
+	int waves;
+
+	NGF_TEST_CONSTRUCTOR(Player), health(100), jumps(0), fallbacks(0), waves(0) { }
+
+	void hit(const MsgHit &msg) { health -= msg.damage; }
+	void heavyHit(const MsgHit &msg) { health -= 2 * msg.damage; }
+	int getHealth(const MsgGetHealth &) { return health; }
+	void jump(const Message &msg) { jumps += msg.getParam<int>(0); }
+
+	MessageReply receiveMessage(const Message &msg)
+	{
+		++fallbacks;
+		if (msg.code == MsgWave::getCode())
+		{
+			waves += msg.getParam<MsgWave>(0).times;
+		}
+		NGF_NO_REPLY();
+	}
+};
+
+//Doesn't get Player's handlers.
+struct Boss : public Player
+{
+	Boss(Ogre::Vector3 pos, Ogre::Quaternion rot, ID id, PropertyList props, Ogre::String name)
+	    : Player(pos, rot, id, props, name) { }
+};
+
+}
+
+NGF_TEST(handlersBeforeReceiveMessage)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	GameObjectFactory::getSingleton().registerObjectType<Player>("Player")
+		.onMessage<MsgHit>(&Player::hit)
+		.onMessage<MsgGetHealth>(&Player::getHealth)
+		.onMessage("jump", &Player::jump);
+	NGF_REGISTER_OBJECT_TYPE(Boss);
+	Player *player = (Player *) mgr.createObject("Player", Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+	Player *boss = (Player *) mgr.createObject("Boss", Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+
+	//Typed, by the typed message's code, and by name.
+	mgr.sendMessage(player, MsgHit(10));
+	mgr.sendMessage(player, (Message(MsgHit::getCode()), MsgHit(5)));
+	mgr.sendMessage(player, (Message("jump"), 2));
+	NGF_CHECK(player->health == 85 && player->jumps == 2 && player->fallbacks == 0);
+	NGF_CHECK(mgr.sendMessageWithReply<int>(player, MsgGetHealth()) == 85);
+
+	//Messages without a handler still get to 'receiveMessage'.
+	mgr.sendMessage(player, MsgWave(3));
+	mgr.sendMessage(player, Message("dance"));
+	NGF_CHECK(player->fallbacks == 2 && player->waves == 3);
+
+	//Handlers aren't inherited.
+	mgr.sendMessage(boss, MsgHit(10));
+	mgr.sendMessage(boss, (Message("jump"), 2));
+	NGF_CHECK(boss->health == 100 && boss->jumps == 0 && boss->fallbacks == 2);
+
+	//Giving a handler again replaces it.
+	GameObjectFactory::getSingleton().registerObjectType<Player>("Player")
+		.onMessage<MsgHit>(&Player::heavyHit);
+	mgr.sendMessage(player, MsgHit(5));
+	NGF_CHECK(player->health == 75 && player->fallbacks == 2);
+	mgr.sendMessage(player, (Message("jump"), 1));
+	NGF_CHECK(player->jumps == 3);
+}
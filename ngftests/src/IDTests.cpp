@@ -0,0 +1,99 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  IDTests.cpp
+ *
+ *    Description:  GameObject IDs: slots, generations and reservation during creation.
+ *
+ *         Author:  Nikhilesh (nikki)
+ *
+ * =====================================================================================
+ */
+
+#include "NgfTest.h"
+
+using namespace NGF;
+
+namespace {
+
+struct Plain : public GameObject
+{
+	NGF_TEST_CONSTRUCTOR(Plain) { }
+};
+
+//Creates a child GameObject from its constructor.
+struct Parent : public GameObject
+{
+	GameObject *child;
+
+	NGF_TEST_CONSTRUCTOR(Parent)
+	{
+		child = GameObjectManager::getSingleton().createObject<Plain>(pos, rot);
+	}
+};
+
+//Creates a GameObject and then fails.
+struct Failing : public GameObject
+{
+	static ID childID;
+
+	NGF_TEST_CONSTRUCTOR(Failing)
+	{
+		childID = GameObjectManager::getSingleton().createObject<Plain>(pos, rot)->getID();
+		OGRE_EXCEPT(Ogre::Exception::ERR_INVALIDPARAMS, "Failing on purpose", "Failing::Failing()");
+	}
+};
+ID Failing::childID = 0;
+
+}
+
+NGF_TEST(staleIDs)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+
+	GameObject *a = mgr.createObject<Plain>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+	ID old = a->getID();
+	mgr.destroyObject(old);
+
+	GameObject *b = mgr.createObject<Plain>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+	NGF_CHECK(GameObjectManager::getIDIndex(b->getID()) == GameObjectManager::getIDIndex(old));
+	NGF_CHECK(b->getID() != old);
+	NGF_CHECK(!mgr.getByID(old));
+	NGF_CHECK(mgr.getByID(b->getID()) == b);
+}
+
+NGF_TEST(createInConstructor)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+
+	Parent *parent = (Parent *) mgr.createObject<Parent>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+	NGF_CHECK(parent->child);
+	NGF_CHECK(parent->getID() != parent->child->getID());
+	NGF_CHECK(mgr.getByID(parent->getID()) == parent);
+	NGF_CHECK(mgr.getByID(parent->child->getID()) == parent->child);
+	NGF_CHECK(mgr.getNumObjects() == 2);
+}
+
+NGF_TEST(failedCreation)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+
+	bool thrown = false;
+	try
+	{
+		mgr.createObject<Failing>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+	}
+	catch (const Ogre::Exception &)
+	{
+		thrown = true;
+	}
+	NGF_CHECK(thrown);
+
+	//The child stays, and the failed GameObject's slot is free again.
+	NGF_CHECK(mgr.getNumObjects() == 1);
+	NGF_CHECK(mgr.getByID(Failing::childID));
+
+	GameObject *next = mgr.createObject<Plain>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+	NGF_CHECK(next->getID() != Failing::childID);
+	NGF_CHECK(mgr.getNumObjects() == 2);
+}
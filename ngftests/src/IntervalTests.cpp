@@ -0,0 +1,114 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  IntervalTests.cpp
+ *
+ *    Description:  Tick intervals: GameObjects spread evenly over the frames of their
+ *                  interval, and getting the time since their last tick.
+ *
+ *         Author:  Nikhilesh (nikki)
+ *
+ * =====================================================================================
+ */
+
+#include "NgfTest.h"
+
+#include <cmath>
+
+using namespace NGF;
+
+namespace {
+
+unsigned int frame = 0;
+unsigned int tickedThisFrame = 0;
+
+//Notes how often it ticks and how much time it's told passed.
+struct Counted : public GameObject
+{
+	unsigned int ticks;
+	unsigned int lastFrame;
+	Ogre::Real total;
+	Ogre::Real last;
+
+	NGF_TEST_CONSTRUCTOR(Counted), ticks(0), lastFrame(0), total(0), last(0) { }
+
+	void unpausedTick(const Ogre::FrameEvent &evt)
+	{
+		++ticks;
+		++tickedThisFrame;
+		lastFrame = frame;
+		total += evt.timeSinceLastFrame;
+		last = evt.timeSinceLastFrame;
+	}
+};
+
+bool near(Ogre::Real a, Ogre::Real b)
+{
+	return std::fabs(a - b) < 1e-4f;
+}
+
+}
+
+NGF_TEST(intervalSpreading)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	mgr.setTypeOptions<Counted>(TypeOptions().tick(TICK_UNPAUSED).interval(4));
+
+	std::vector<Counted*> objs;
+	for (unsigned int i = 0; i < 40; ++i)
+	{
+		objs.push_back((Counted *) mgr.createObject<Counted>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY));
+	}
+
+	//Frames of different lengths, and the time at the end of each.
+	const Ogre::Real times[] = { 0.1f, 0.2f, 0.3f, 0.4f, 0.5f, 0.5f, 0.25f, 0.125f };
+	Ogre::Real clock[9] = { 0 };
+	for (frame = 1; frame <= 8; ++frame)
+	{
+		tickedThisFrame = 0;
+		mgr.tick(false, NGFTest::frameEvent(times[frame - 1]));
+		clock[frame] = clock[frame - 1] + times[frame - 1];
+		NGF_CHECK(tickedThisFrame == 10);
+	}
+
+	//Each ticked once per interval, and was given all the time up to its last tick.
+	for (unsigned int i = 0; i < objs.size(); ++i)
+	{
+		NGF_CHECK(objs[i]->ticks == 2);
+		NGF_CHECK(objs[i]->lastFrame >= 5);
+		NGF_CHECK(near(objs[i]->total, clock[objs[i]->lastFrame]));
+		NGF_CHECK(near(objs[i]->last, clock[objs[i]->lastFrame] - clock[objs[i]->lastFrame - 4]));
+	}
+}
+
+NGF_TEST(intervalPerObject)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	mgr.setTypeOptions<Counted>(TypeOptions().tick(TICK_UNPAUSED).interval(3));
+
+	Counted *typeRate = (Counted *) mgr.createObject<Counted>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+	Counted *everyFrame = (Counted *) mgr.createObject<Counted>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+	Counted *halfRate = (Counted *) mgr.createObject<Counted>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+	everyFrame->setTickInterval(1);
+	halfRate->setTickInterval(2);
+	NGF_CHECK(everyFrame->getTickInterval() == 1 && typeRate->getTickInterval() == 0);
+
+	for (frame = 1; frame <= 6; ++frame)
+	{
+		mgr.tick(false, NGFTest::frameEvent(0.5f));
+		NGF_CHECK(near(everyFrame->last, 0.5f));
+	}
+	NGF_CHECK(typeRate->ticks == 2 && near(typeRate->total, typeRate->lastFrame * 0.5f));
+	NGF_CHECK(everyFrame->ticks == 6 && near(everyFrame->total, 3));
+	NGF_CHECK(halfRate->ticks == 3 && near(halfRate->total, halfRate->lastFrame * 0.5f));
+	NGF_CHECK(near(typeRate->last, 1.5f) && near(halfRate->last, 1));
+
+	//Back to the type's interval.
+	everyFrame->setTickInterval(0);
+	everyFrame->ticks = 0;
+	for (frame = 7; frame <= 12; ++frame)
+	{
+		mgr.tick(false, NGFTest::frameEvent(0.5f));
+	}
+	NGF_CHECK(everyFrame->ticks == 2);
+}
@@ -0,0 +1,83 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  MessageTests.cpp
+ *
+ *    Description:  Messages: parameters, and replies given as MessageReplies or as
+ *                  boost::anys.
+ *
+ *         Author:  Nikhilesh (nikki)
+ *
+ * =====================================================================================
+ */
+
+#include "NgfTest.h"
+
+using namespace NGF;
+
+namespace {
+
+struct Receiver : public GameObject
+{
+	NGF_TEST_CONSTRUCTOR(Receiver) { }
+
+	MessageReply receiveMessage(const Message &msg)
+	{
+		if (msg.code == NGF_MSG("add"))
+		{
+			NGF_SEND_REPLY(msg.getParam<int>(0) + msg.getParam<int>(1));
+		}
+		if (msg.name == "addAny")
+		{
+			return boost::any(msg.getParam<int>(0) + msg.getParam<int>(1));
+		}
+		if (msg.name == "where")
+		{
+			NGF_SEND_REPLY(msg.getParam<Ogre::Vector3>(0) * 2);
+		}
+		NGF_NO_REPLY();
+	}
+};
+
+}
+
+NGF_TEST(messageParams)
+{
+	Message msg = (Message("params"), 1, 2.5f, Ogre::Vector3(1, 2, 3), Ogre::String("four"), 5u, true);
+	NGF_CHECK(msg.params.size() == 6);
+	NGF_CHECK(msg.getParam<int>(0) == 1 && msg.getParam<float>(1) == 2.5f);
+	NGF_CHECK(msg.getParam<Ogre::Vector3>(2) == Ogre::Vector3(1, 2, 3));
+	NGF_CHECK(msg.getParam<Ogre::String>(3) == "four");
+	NGF_CHECK(msg.getParam<unsigned int>(4) == 5 && msg.getParam<bool>(5));
+	NGF_CHECK(!msg.params[0].find<float>());
+
+	bool thrown = false;
+	try
+	{
+		msg.getParam<double>(1);
+	}
+	catch (const boost::bad_any_cast &)
+	{
+		thrown = true;
+	}
+	NGF_CHECK(thrown);
+}
+
+NGF_TEST(messageReplies)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	GameObject *obj = mgr.createObject<Receiver>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+
+	NGF_CHECK(mgr.sendMessageWithReply<int>(obj, (Message("add"), 2, 3)) == 5);
+	NGF_CHECK(mgr.sendMessageWithReply<int>(obj, (Message("addAny"), 2, 3)) == 5);
+	NGF_CHECK(mgr.sendMessageWithReply<Ogre::Vector3>(obj, (Message("where"), Ogre::Vector3(1, 0, 0))) 
+			== Ogre::Vector3(2, 0, 0));
+
+	//Replies kept as boost::anys.
+	NGF_CHECK(boost::any_cast<int>(mgr.sendMessageWithReply<boost::any>(obj, (Message("addAny"), 4, 5))) == 9);
+	NGF_CHECK(boost::any_cast<int>(mgr.sendMessageWithReply<boost::any>(obj, (Message("add"), 1, 1))) == 2);
+	MessageReply reply = obj->receiveMessage((Message("add"), 4, 5));
+	NGF_CHECK(boost::any_cast<int>(reply) == 9);
+	boost::any any = reply;
+	NGF_CHECK(boost::any_cast<int>(any) == 9);
+}
@@ -0,0 +1,112 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  NameTests.cpp
+ *
+ *    Description:  The name index: lookups, duplicates, and loading many named
+ *                  GameObjects.
+ *
+ *         Author:  Nikhilesh (nikki)
+ *
+ * =====================================================================================
+ */
+
+#include "NgfTest.h"
+
+using namespace NGF;
+
+namespace {
+
+struct Named : public GameObject
+{
+	NGF_TEST_CONSTRUCTOR(Named) { }
+};
+
+Ogre::String nameOf(unsigned int i)
+{
+	return "obj" + Ogre::StringConverter::toString(i);
+}
+
+}
+
+NGF_TEST(nameIndex)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	NGF_REGISTER_OBJECT_TYPE(Named);
+
+	GameObject *a = mgr.createObject<Named>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY, PropertyList(), "a");
+	mgr.createObject<Named>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY, PropertyList(), "noname");
+	NGF_CHECK(mgr.getByName("a") == a);
+	NGF_CHECK(!mgr.getByName("b"));
+
+	bool thrown = false;
+	try
+	{
+		mgr.createObject<Named>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY, PropertyList(), "a");
+	}
+	catch (const Ogre::Exception &)
+	{
+		thrown = true;
+	}
+	NGF_CHECK(thrown);
+
+	//Duplicates within a batch are found too.
+	ObjectSpawn spawns[2] = {
+		ObjectSpawn("Named", Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY, PropertyList(), "c"),
+		ObjectSpawn("Named", Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY, PropertyList(), "c")
+	};
+	thrown = false;
+	try
+	{
+		mgr.createObjects(spawns, 2);
+	}
+	catch (const Ogre::Exception &)
+	{
+		thrown = true;
+	}
+	NGF_CHECK(thrown);
+	NGF_CHECK(!mgr.getByName("c"));
+
+	mgr.destroyObject(a->getID());
+	NGF_CHECK(!mgr.getByName("a"));
+	NGF_CHECK(mgr.createObject<Named>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY, PropertyList(), "a"));
+}
+
+NGF_BENCH(loadNamed)
+{
+	const unsigned int num = 50000;
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	NGF_REGISTER_OBJECT_TYPE(Named);
+
+	std::vector<ObjectSpawn> spawns;
+	spawns.reserve(num);
+	for (unsigned int i = 0; i < num; ++i)
+	{
+		spawns.push_back(ObjectSpawn("Named", Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY, 
+					PropertyList(), nameOf(i)));
+	}
+
+	//The way Loader::loadLevel creates them.
+	Ogre::Timer timer;
+	mgr.createObjects(spawns);
+	NGFTest::report("createObjects, 50k named", timer.getMicroseconds());
+	NGF_CHECK(mgr.getNumObjects() == num);
+
+	timer.reset();
+	unsigned int found = 0;
+	for (unsigned int i = 0; i < num; ++i)
+	{
+		found += mgr.getByName(spawns[i].name) != NULL;
+	}
+	NGFTest::report("getByName, 50k", timer.getMicroseconds());
+	NGF_CHECK(found == num);
+
+	timer.reset();
+	mgr.destroyAll();
+	for (unsigned int i = 0; i < num; ++i)
+	{
+		mgr.createObject<Named>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY, PropertyList(), spawns[i].name);
+	}
+	NGFTest::report("destroyAll, then createObject, 50k named", timer.getMicroseconds());
+	NGF_CHECK(mgr.getNumObjects() == num);
+}
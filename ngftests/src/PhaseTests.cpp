@@ -0,0 +1,148 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  PhaseTests.cpp
+ *
+ *    Description:  Tick phases: types ticking in the order their phases depend on each
+ *                  other, and phases that can't be ordered.
+ *
+ *         Author:  Nikhilesh (nikki)
+ *
+ * =====================================================================================
+ */
+
+#include "NgfTest.h"
+
+#include <algorithm>
+
+using namespace NGF;
+
+namespace {
+
+std::vector<int> ticked;
+
+//Notes its number when it ticks. One type for each number, so each can have a phase.
+template<int N>
+struct Stage : public GameObject
+{
+	NGF_TEST_CONSTRUCTOR(Stage) { }
+
+	void unpausedTick(const Ogre::FrameEvent &) { ticked.push_back(N); }
+};
+
+template<int N>
+void addStage(const Ogre::String &phase)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	mgr.setTypeOptions<Stage<N> >(TypeOptions().tick(TICK_UNPAUSED).phase(phase));
+	mgr.createObject<Stage<N> >(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+}
+
+//Whether 'first' ticked before 'second' in the last frame.
+bool before(int first, int second)
+{
+	std::vector<int>::iterator a = std::find(ticked.begin(), ticked.end(), first);
+	std::vector<int>::iterator b = std::find(ticked.begin(), ticked.end(), second);
+	return a != ticked.end() && b != ticked.end() && a < b;
+}
+
+}
+
+NGF_TEST(phaseOrder)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	mgr.addTickPhase("AI", "PrePhysics");
+	mgr.addTickPhase("Camera", "Late  AI");
+	NGF_CHECK(mgr.hasTickPhase("AI") && mgr.hasTickPhase("Physics") && !mgr.hasTickPhase("Sound"));
+
+	//Created out of order, so the order comes from the phases.
+	addStage<0>("Late");
+	addStage<1>("Camera");
+	addStage<2>("PrePhysics");
+	addStage<3>("Physics");
+	addStage<4>("Default");
+	addStage<5>("AI");
+	addStage<6>("PostPhysics");
+
+	ticked.clear();
+	mgr.tick(false, NGFTest::frameEvent(0.016f));
+	NGF_CHECK(ticked.size() == 7);
+	NGF_CHECK(before(2, 3) && before(3, 4) && before(3, 6) && before(4, 0) && before(6, 0));
+	NGF_CHECK(before(2, 5) && before(5, 1) && before(0, 1));
+
+	//Phases added later are scheduled on the next tick.
+	mgr.addTickPhase("Last", "Camera");
+	addStage<7>("Last");
+	ticked.clear();
+	mgr.tick(false, NGFTest::frameEvent(0.016f));
+	NGF_CHECK(ticked.size() == 8 && ticked.back() == 7);
+
+	bool threw = false;
+	try
+	{
+		mgr.addTickPhase("AI");
+	}
+	catch (Ogre::Exception &)
+	{
+		threw = true;
+	}
+	NGF_CHECK(threw);
+}
+
+NGF_TEST(phaseCycle)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	mgr.addTickPhase("Chicken", "Egg");
+	mgr.addTickPhase("Egg", "Hatch");
+	mgr.addTickPhase("Hatch", "Chicken Physics");
+	addStage<0>("Default");
+
+	ticked.clear();
+	bool threw = false;
+	try
+	{
+		mgr.tick(false, NGFTest::frameEvent(0.016f));
+	}
+	catch (Ogre::Exception &)
+	{
+		threw = true;
+	}
+	NGF_CHECK(threw);
+	NGF_CHECK(ticked.empty());
+}
+
+NGF_TEST(phaseUnknownNames)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	addStage<0>("Sound");
+
+	//A type in a phase that doesn't exist.
+	bool threw = false;
+	try
+	{
+		mgr.tick(false, NGFTest::frameEvent(0.016f));
+	}
+	catch (Ogre::Exception &)
+	{
+		threw = true;
+	}
+	NGF_CHECK(threw);
+
+	mgr.addTickPhase("Sound", "Late");
+	ticked.clear();
+	mgr.tick(false, NGFTest::frameEvent(0.016f));
+	NGF_CHECK(ticked.size() == 1);
+
+	//A phase after one that doesn't exist.
+	mgr.addTickPhase("Music", "Sound Radio");
+	threw = false;
+	try
+	{
+		mgr.tick(false, NGFTest::frameEvent(0.016f));
+	}
+	catch (Ogre::Exception &)
+	{
+		threw = true;
+	}
+	NGF_CHECK(threw);
+}
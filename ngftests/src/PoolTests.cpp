@@ -0,0 +1,128 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  PoolTests.cpp
+ *
+ *    Description:  Pooled types: freed places reused by later GameObjects, and the pool
+ *                  statistics.
+ *
+ *         Author:  Nikhilesh (nikki)
+ *
+ * =====================================================================================
+ */
+
+#include "NgfTest.h"
+
+#include <set>
+
+using namespace NGF;
+
+namespace {
+
+struct Bullet : public GameObject
+{
+	static int numAlive;
+	Ogre::Vector3 velocity;
+
+	NGF_TEST_CONSTRUCTOR(Bullet), velocity(pos * 2) { ++numAlive; }
+	~Bullet() { --numAlive; }
+};
+int Bullet::numAlive = 0;
+
+//Fails in its constructor, when asked to.
+struct Dud : public GameObject
+{
+	static bool fail;
+
+	NGF_TEST_CONSTRUCTOR(Dud)
+	{
+		if (fail)
+		{
+			OGRE_EXCEPT(Ogre::Exception::ERR_INVALIDPARAMS, "Failing on purpose", "Dud::Dud()");
+		}
+	}
+};
+bool Dud::fail = false;
+
+struct Unpooled : public GameObject
+{
+	NGF_TEST_CONSTRUCTOR(Unpooled) { }
+};
+
+}
+
+NGF_TEST(poolReuse)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	mgr.setTypeOptions<Bullet>(TypeOptions().pool(8));
+	Bullet::numAlive = 0;
+
+	std::vector<GameObject*> objs;
+	for (unsigned int i = 0; i < 20; ++i)
+	{
+		objs.push_back(mgr.createObject<Bullet>(Ogre::Vector3(i, 0, 0), Ogre::Quaternion::IDENTITY));
+	}
+	PoolStats stats = mgr.getPoolStats<Bullet>();
+	NGF_CHECK(stats.numSlabs == 3 && stats.capacity == 24);
+	NGF_CHECK(stats.numUsed == 20 && stats.peakUsed == 20);
+	NGF_CHECK(((Bullet *) objs[7])->velocity == Ogre::Vector3(14, 0, 0));
+
+	//Destroyed ones are destructed, and their places given to the next ones.
+	std::set<GameObject*> freed;
+	for (unsigned int i = 0; i < 20; i += 2)
+	{
+		freed.insert(objs[i]);
+		mgr.destroyObject(objs[i]->getID());
+	}
+	NGF_CHECK(Bullet::numAlive == 10);
+	stats = mgr.getPoolStats<Bullet>();
+	NGF_CHECK(stats.numUsed == 10 && stats.peakUsed == 20 && stats.numSlabs == 3);
+
+	for (unsigned int i = 0; i < 10; ++i)
+	{
+		GameObject *obj = mgr.createObject<Bullet>(Ogre::Vector3(1, 1, 1), Ogre::Quaternion::IDENTITY);
+		NGF_CHECK(freed.count(obj) == 1);
+		NGF_CHECK(((Bullet *) obj)->velocity == Ogre::Vector3(2, 2, 2));
+	}
+	stats = mgr.getPoolStats<Bullet>();
+	NGF_CHECK(stats.numUsed == 20 && stats.numSlabs == 3);
+
+	//The pool is kept around for the next level.
+	mgr.destroyAll();
+	NGF_CHECK(Bullet::numAlive == 0);
+	stats = mgr.getPoolStats<Bullet>();
+	NGF_CHECK(stats.numUsed == 0 && stats.peakUsed == 20 && stats.capacity == 24);
+}
+
+NGF_TEST(poolFailedCreation)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	mgr.setTypeOptions<Dud>(TypeOptions().pool(4));
+
+	Dud::fail = false;
+	GameObject *first = mgr.createObject<Dud>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+	mgr.destroyObject(first->getID());
+
+	//The place of a GameObject that failed goes back to the pool.
+	Dud::fail = true;
+	bool threw = false;
+	try
+	{
+		mgr.createObject<Dud>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+	}
+	catch (Ogre::Exception &)
+	{
+		threw = true;
+	}
+	NGF_CHECK(threw);
+	NGF_CHECK(mgr.getPoolStats<Dud>().numUsed == 0);
+
+	Dud::fail = false;
+	NGF_CHECK(mgr.createObject<Dud>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY) == first);
+	NGF_CHECK(mgr.getPoolStats<Dud>().numSlabs == 1);
+
+	//Types without a pool have no statistics.
+	mgr.createObject<Unpooled>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+	PoolStats stats = mgr.getPoolStats<Unpooled>();
+	NGF_CHECK(stats.numSlabs == 0 && stats.capacity == 0 && stats.numUsed == 0 && stats.peakUsed == 0);
+}
@@ -0,0 +1,60 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  PostTests.cpp
+ *
+ *    Description:  Posting messages by GameObject and by ID.
+ *
+ *         Author:  Nikhilesh (nikki)
+ *
+ * =====================================================================================
+ */
+
+#include "NgfTest.h"
+
+using namespace NGF;
+
+namespace {
+
+struct Counter : public GameObject
+{
+	std::vector<int> got;
+
+	NGF_TEST_CONSTRUCTOR(Counter) { }
+
+	MessageReply receiveMessage(const Message &msg)
+	{
+		got.push_back(msg.getParam<int>(0));
+		NGF_NO_REPLY();
+	}
+};
+
+}
+
+NGF_TEST(postByPointerAndID)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	Counter *a = (Counter *) mgr.createObject<Counter>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+	Counter *b = (Counter *) mgr.createObject<Counter>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+	ID bID = b->getID();
+
+	//A literal 0 is a null GameObject, which nothing is posted to.
+	NGF_CHECK(!mgr.postMessage(0, (Message("count"), 0)));
+	NGF_CHECK(mgr.getNumPostedMessages() == 0);
+
+	NGF_CHECK(mgr.postMessage(a, (Message("count"), 1)));
+	NGF_CHECK(mgr.postMessageByID(a->getID(), (Message("count"), 2)));
+	NGF_CHECK(mgr.postMessageByID(bID, (Message("count"), 3)));
+	NGF_CHECK(mgr.getNumPostedMessages() == 3);
+
+	mgr.deliverMessages();
+	NGF_CHECK(a->got.size() == 2 && a->got[0] == 1 && a->got[1] == 2);
+	NGF_CHECK(b->got.size() == 1 && b->got[0] == 3);
+
+	//Posting to the ID of a GameObject that's gone by delivery drops the message.
+	NGF_CHECK(mgr.postMessageByID(bID, (Message("count"), 4)));
+	mgr.destroyObject(bID);
+	mgr.deliverMessages();
+	NGF_CHECK(mgr.getNumPostedMessages() == 0);
+	NGF_CHECK(a->got.size() == 2);
+}
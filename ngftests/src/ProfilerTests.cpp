@@ -0,0 +1,190 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  ProfilerTests.cpp
+ *
+ *    Description:  The profiler: per-type stats, traces, and turning it on and off.
+ *                  Needs NGF_ENABLE_PROFILER.
+ *
+ *         Author:  Nikhilesh (nikki)
+ *
+ * =====================================================================================
+ */
+
+#include "NgfTest.h"
+
+#ifdef NGF_ENABLE_PROFILER
+
+#include <sstream>
+
+using namespace NGF;
+
+namespace {
+
+struct Ping : public TypedMessage<Ping> { };
+
+struct Busy : public GameObject
+{
+	int pings;
+
+	NGF_TEST_CONSTRUCTOR(Busy), pings(0) { }
+
+	void unpausedTick(const Ogre::FrameEvent &) 
+	{ 
+		volatile double x = 0; 
+		for (int i = 0; i < 20000; ++i) 
+		{
+			x += i; 
+		}
+	}
+
+	void ping(const Ping &) { ++pings; }
+};
+
+struct Lazy : public GameObject
+{
+	NGF_TEST_CONSTRUCTOR(Lazy) { }
+
+	void unpausedTick(const Ogre::FrameEvent &) { }
+};
+
+//Tries to turn the profiler off from a parallel tick.
+struct Switcher : public GameObject
+{
+	bool threw;
+
+	NGF_TEST_CONSTRUCTOR(Switcher), threw(false) { }
+
+	void unpausedTick(const Ogre::FrameEvent &)
+	{
+		try
+		{
+			GameObjectManager::getSingleton().setProfiling(false);
+		}
+		catch (Ogre::Exception &)
+		{
+			threw = true;
+		}
+	}
+};
+
+}
+
+NGF_TEST(profileStats)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	GameObjectFactory::getSingleton().registerObjectType<Busy>("Busy").onMessage<Ping>(&Busy::ping);
+	GameObjectFactory::getSingleton().registerObjectType<Lazy>("Lazy", TypeOptions().pool(16));
+	Busy *busy = (Busy *) mgr.createObject("Busy", Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+
+	//Nothing is recorded while it's off.
+	mgr.tick(false, NGFTest::frameEvent(0.1f));
+	NGF_CHECK(mgr.getProfileStats().empty());
+
+	mgr.setProfiling(true);
+	NGF_CHECK(mgr.isProfiling());
+	for (unsigned int i = 0; i < 5; ++i)
+	{
+		mgr.createObject("Lazy", Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+	}
+	mgr.tick(false, NGFTest::frameEvent(0.1f));
+	mgr.sendMessage(busy, Ping());
+	mgr.sendMessage(busy, Message("hello"));
+	mgr.tick(false, NGFTest::frameEvent(0.1f));
+
+	ProfileStats busyStats = mgr.getProfileStats("Busy"), lazyStats = mgr.getProfileStats("Lazy");
+	NGF_CHECK(busyStats.calls[PROFILE_TICK] == 2 && busyStats.calls[PROFILE_MESSAGE] == 2);
+	NGF_CHECK(lazyStats.calls[PROFILE_CREATE] == 5 && lazyStats.calls[PROFILE_TICK] == 10);
+	NGF_CHECK(lazyStats.allocations == 5 && lazyStats.pooledAllocations == 5);
+	NGF_CHECK(busyStats.time[PROFILE_TICK] > lazyStats.time[PROFILE_TICK]);
+	NGF_CHECK(mgr.getProfileStats("").calls[PROFILE_TICK] == 2);
+
+	mgr.destroyObject(busy->getID());
+	NGF_CHECK(mgr.getProfileStats("Busy").calls[PROFILE_DESTROY] == 1);
+
+	mgr.resetProfile();
+	NGF_CHECK(mgr.getProfileStats().empty());
+	mgr.setProfiling(false);
+	mgr.tick(false, NGFTest::frameEvent(0.1f));
+	NGF_CHECK(mgr.getProfileStats().empty());
+}
+
+NGF_TEST(profileTrace)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	GameObjectFactory::getSingleton().registerObjectType<Busy>("Busy").onMessage<Ping>(&Busy::ping);
+	mgr.createObject("Busy", Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+
+	mgr.setProfiling(true);
+	mgr.setProfileTracing(true, 1000);
+	mgr.tick(false, NGFTest::frameEvent(0.1f));
+	{
+		ProfileScope scope(ProfileScope::NO_TYPE, PROFILE_LOAD, Ogre::String("level \"1\""));
+	}
+
+	std::ostringstream trace;
+	mgr.writeProfileTrace(trace);
+	NGF_CHECK(trace.str().find("\"traceEvents\"") != std::string::npos);
+	NGF_CHECK(trace.str().find("\"name\":\"Busy\",\"cat\":\"tick\"") != std::string::npos);
+	NGF_CHECK(trace.str().find("level \\\"1\\\"") != std::string::npos);
+
+	bool threw = false;
+	try
+	{
+		mgr.writeProfileTrace("/nonexistent/dir/trace.json");
+	}
+	catch (Ogre::Exception &)
+	{
+		threw = true;
+	}
+	NGF_CHECK(threw);
+	mgr.setProfiling(false);
+}
+
+//Frames where none of a type tick don't leave empty tick events.
+NGF_TEST(profileIdleTicks)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	GameObjectFactory::getSingleton().registerObjectType<Lazy>("Lazy", TypeOptions().interval(4));
+	mgr.createObject("Lazy", Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+
+	mgr.setProfiling(true);
+	mgr.setProfileTracing(true, 1000);
+	for (unsigned int i = 0; i < 4; ++i)
+	{
+		mgr.tick(false, NGFTest::frameEvent(0.1f));
+	}
+	NGF_CHECK(mgr.getProfileStats("Lazy").calls[PROFILE_TICK] == 1);
+
+	std::ostringstream trace;
+	mgr.writeProfileTrace(trace);
+	const std::string event = "\"name\":\"Lazy\",\"cat\":\"tick\"";
+	std::string::size_type first = trace.str().find(event);
+	NGF_CHECK(first != std::string::npos);
+	NGF_CHECK(trace.str().find(event, first + 1) == std::string::npos);
+	mgr.setProfiling(false);
+}
+
+NGF_TEST(profileSwitchInParallel)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	GameObjectFactory::getSingleton().registerObjectType<Switcher>("Switcher", TypeOptions().parallel());
+	mgr.setTickThreads(2, 4);
+	std::vector<Switcher *> switchers;
+	for (unsigned int i = 0; i < 16; ++i)
+	{
+		switchers.push_back((Switcher *) mgr.createObject("Switcher", Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY));
+	}
+
+	mgr.setProfiling(true);
+	mgr.tick(false, NGFTest::frameEvent(0.1f));
+	NGF_CHECK(mgr.isProfiling());
+	for (unsigned int i = 0; i < switchers.size(); ++i)
+	{
+		NGF_CHECK(switchers[i]->threw);
+	}
+	NGF_CHECK(mgr.getProfileStats("Switcher").calls[PROFILE_TICK] == 16);
+	mgr.setProfiling(false);
+}
+
+#endif
@@ -0,0 +1,84 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  RecycleTests.cpp
+ *
+ *    Description:  Recycled GameObjects: what they keep and what they start over with.
+ *
+ *         Author:  Nikhilesh (nikki)
+ *
+ * =====================================================================================
+ */
+
+#include "NgfTest.h"
+
+#include <iterator>
+
+using namespace NGF;
+
+namespace {
+
+struct Shot : public GameObject
+{
+	static unsigned int numConstructed;
+	unsigned int ticks;
+
+	NGF_TEST_CONSTRUCTOR(Shot), ticks(0)
+	{
+		++numConstructed;
+		setTickFlags(TICK_UNPAUSED);
+		addFlag("Shot");
+	}
+
+	void unpausedTick(const Ogre::FrameEvent &) { ++ticks; }
+
+	void reactivate(Ogre::Vector3, Ogre::Quaternion, PropertyList)
+	{
+		ticks = 0;
+		addFlag("Shot");
+	}
+};
+unsigned int Shot::numConstructed = 0;
+
+unsigned int count(GameObjectManager::ObjectRange range)
+{
+	return std::distance(range.first, range.second);
+}
+
+}
+
+NGF_TEST(recycledState)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	mgr.setTypeOptions<Shot>(TypeOptions().recycle(4));
+
+	Shot::numConstructed = 0;
+	GameObject *shot = mgr.createObject<Shot>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+	shot->addFlag("Burning");
+	shot->setPersistent(true);
+	shot->setTickInterval(3);
+	shot->setDeferrableTick(true, 2);
+	ID old = shot->getID();
+	mgr.destroyObject(old);
+
+	//Same GameObject, new life.
+	GameObject *again = mgr.createObject<Shot>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+	NGF_CHECK(again == shot && Shot::numConstructed == 1);
+	NGF_CHECK(again->getID() != old && !mgr.getByID(old));
+
+	NGF_CHECK(!again->hasFlag("Burning") && again->hasFlag("Shot"));
+	NGF_CHECK(count(mgr.getObjectsWithFlag("Burning")) == 0);
+	NGF_CHECK(count(mgr.getObjectsWithFlag("Shot")) == 1);
+	NGF_CHECK(!again->isPersistent());
+	NGF_CHECK(again->getTickInterval() == 0 && !again->isTickDeferrable());
+
+	//The tick flags are kept, so it ticks every frame again.
+	NGF_CHECK(again->getTickFlags() == TICK_UNPAUSED);
+	mgr.tick(false, NGFTest::frameEvent(0.1f));
+	mgr.tick(false, NGFTest::frameEvent(0.1f));
+	NGF_CHECK(((Shot *) again)->ticks == 2);
+
+	//Not persistent any more, so it goes.
+	mgr.destroyAll();
+	NGF_CHECK(mgr.getNumObjects() == 0);
+}
@@ -0,0 +1,100 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  RegistryTests.cpp
+ *
+ *    Description:  The flag and message registries, used from many threads at once.
+ *
+ *         Author:  Nikhilesh (nikki)
+ *
+ * =====================================================================================
+ */
+
+#include "NgfTest.h"
+
+#include "boost/thread/thread.hpp"
+#include "boost/bind.hpp"
+
+using namespace NGF;
+
+namespace {
+
+const unsigned int NUM_THREADS = 8;
+const unsigned int NUM_NAMES = 16;
+
+//Each thread asks for the same names, starting at a different one.
+void makeFlags(unsigned int start, std::vector<FlagID> *flags)
+{
+	flags->resize(NUM_NAMES);
+	for (unsigned int round = 0; round < 200; ++round)
+	{
+		for (unsigned int n = 0; n < NUM_NAMES; ++n)
+		{
+			unsigned int i = (start + n) % NUM_NAMES;
+			(*flags)[i] = FlagRegistry::getFlag("Concurrent" + Ogre::StringConverter::toString(i));
+			FlagRegistry::getFlagName((*flags)[i]);
+		}
+	}
+}
+
+}
+
+NGF_TEST(concurrentFlags)
+{
+	std::vector<std::vector<FlagID> > flags(NUM_THREADS);
+	boost::thread_group threads;
+	for (unsigned int t = 0; t < NUM_THREADS; ++t)
+	{
+		threads.create_thread(boost::bind(&makeFlags, t * 3, &flags[t]));
+	}
+	threads.join_all();
+
+	//Everyone got the same flag for a name, and each name got its own.
+	for (unsigned int i = 0; i < NUM_NAMES; ++i)
+	{
+		NGF_CHECK(FlagRegistry::getFlagName(flags[0][i]) == "Concurrent" + Ogre::StringConverter::toString(i));
+		for (unsigned int t = 1; t < NUM_THREADS; ++t)
+		{
+			NGF_CHECK(flags[t][i] == flags[0][i]);
+		}
+	}
+}
+
+namespace {
+
+void makeMessages(unsigned int start, std::vector<unsigned int> *codes)
+{
+	codes->resize(NUM_NAMES);
+	for (unsigned int round = 0; round < 200; ++round)
+	{
+		for (unsigned int n = 0; n < NUM_NAMES; ++n)
+		{
+			unsigned int i = (start + n) % NUM_NAMES;
+			Message msg("concurrent" + Ogre::StringConverter::toString(i));
+			(*codes)[i] = msg.code;
+			MessageRegistry::getName(msg.code);
+		}
+	}
+}
+
+}
+
+NGF_TEST(concurrentMessageNames)
+{
+	std::vector<std::vector<unsigned int> > codes(NUM_THREADS);
+	boost::thread_group threads;
+	for (unsigned int t = 0; t < NUM_THREADS; ++t)
+	{
+		threads.create_thread(boost::bind(&makeMessages, t * 5, &codes[t]));
+	}
+	threads.join_all();
+
+	for (unsigned int i = 0; i < NUM_NAMES; ++i)
+	{
+		NGF_CHECK(MessageRegistry::getName(codes[0][i]) == "concurrent" + Ogre::StringConverter::toString(i));
+		for (unsigned int t = 1; t < NUM_THREADS; ++t)
+		{
+			NGF_CHECK(codes[t][i] == codes[0][i]);
+		}
+	}
+}
@@ -0,0 +1,132 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  ReplyTests.cpp
+ *
+ *    Description:  Replies that may not come: trySendMessageWithReply's statuses.
+ *
+ *         Author:  Nikhilesh (nikki)
+ *
+ * =====================================================================================
+ */
+
+#include "NgfTest.h"
+
+using namespace NGF;
+
+namespace {
+
+struct MsgGetHealth : public TypedMessage<MsgGetHealth> { };
+
+struct Patient : public GameObject
+{
+	NGF_TEST_CONSTRUCTOR(Patient) { }
+
+	int health(const MsgGetHealth &) { return 42; }
+
+	MessageReply receiveMessage(const Message &msg)
+	{
+		if (msg.code == NGF_MSG("where"))
+		{
+			NGF_SEND_REPLY(Ogre::Vector3(1, 2, 3));
+		}
+		if (msg.code == NGF_MSG("status"))
+		{
+			NGF_SEND_REPLY(REPLY_DROPPED);
+		}
+		NGF_NO_REPLY();
+	}
+};
+
+//Asks a Patient for its health from a parallel tick.
+struct Asker : public GameObject
+{
+	static ID patient;
+	ReplyStatus status;
+
+	NGF_TEST_CONSTRUCTOR(Asker), status(REPLY_OK) { }
+
+	void unpausedTick(const Ogre::FrameEvent &)
+	{
+		GameObjectManager &mgr = GameObjectManager::getSingleton();
+		status = mgr.trySendMessageWithReply<int>(mgr.getByID(patient), MsgGetHealth()).status;
+	}
+};
+ID Asker::patient = 0;
+
+}
+
+NGF_TEST(trySendStatuses)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	GameObjectFactory::getSingleton().registerObjectType<Patient>("Patient").onMessage<MsgGetHealth>(&Patient::health);
+	GameObject *patient = mgr.createObject("Patient", Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+
+	Reply<int> health = mgr.trySendMessageWithReply<int>(patient, MsgGetHealth());
+	NGF_CHECK(health.ok() && health.get() == 42);
+	NGF_CHECK(mgr.trySendMessageWithReply<Ogre::Vector3>(patient, Message("where")).get() == Ogre::Vector3(1, 2, 3));
+
+	NGF_CHECK(mgr.trySendMessageWithReply<int>(0, MsgGetHealth()).status == REPLY_NO_OBJECT);
+	NGF_CHECK(mgr.trySendMessageWithReply<float>(patient, MsgGetHealth()).status == REPLY_BAD_TYPE);
+
+	Reply<int> none = mgr.trySendMessageWithReply<int>(patient, Message("nothing"));
+	NGF_CHECK(none.status == REPLY_NONE && !none.ok() && none.getOr(-1) == -1);
+
+	//Replies that are themselves statuses aren't taken for the status of the reply.
+	Reply<ReplyStatus> status = mgr.trySendMessageWithReply<ReplyStatus>(patient, Message("status"));
+	NGF_CHECK(status.ok() && status.get() == REPLY_DROPPED);
+	status = mgr.trySendMessageWithReply<ReplyStatus>(patient, Message("nothing"));
+	NGF_CHECK(status.status == REPLY_NONE && status.getOr(REPLY_OK) == REPLY_OK);
+	NGF_CHECK(Reply<int>(REPLY_NONE).get() == REPLY_NONE);
+	NGF_CHECK(Reply<int>::failed(REPLY_NONE).status == REPLY_NONE);
+
+	//sendMessageWithReply still throws for what trySendMessageWithReply gives a status.
+	bool threw = false;
+	try
+	{
+		mgr.sendMessageWithReply<float>(patient, MsgGetHealth());
+	}
+	catch (Ogre::Exception &)
+	{
+		threw = true;
+	}
+	NGF_CHECK(threw);
+}
+
+NGF_TEST(trySendInParallel)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	GameObjectFactory::getSingleton().registerObjectType<Patient>("Patient").onMessage<MsgGetHealth>(&Patient::health);
+	mgr.setTypeOptions<Asker>(TypeOptions().parallel());
+	mgr.setTickThreads(2, 4);
+
+	Asker::patient = mgr.createObject("Patient", Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY)->getID();
+	std::vector<Asker *> askers;
+	for (unsigned int i = 0; i < 16; ++i)
+	{
+		askers.push_back((Asker *) mgr.createObject<Asker>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY));
+	}
+
+	mgr.tick(false, NGFTest::frameEvent(0.1f));
+	for (unsigned int i = 0; i < askers.size(); ++i)
+	{
+		NGF_CHECK(askers[i]->status == REPLY_IN_PARALLEL);
+	}
+}
+
+//Asking for the wrong type a lot should be cheap, no exceptions thrown.
+NGF_BENCH(failedTries)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	GameObjectFactory::getSingleton().registerObjectType<Patient>("Patient").onMessage<MsgGetHealth>(&Patient::health);
+	GameObject *patient = mgr.createObject("Patient", Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+
+	unsigned int missed = 0;
+	Ogre::Timer timer;
+	for (unsigned int i = 0; i < 1000000; ++i)
+	{
+		missed += mgr.trySendMessageWithReply<float>(patient, MsgGetHealth()).ok() ? 0 : 1;
+	}
+	NGFTest::report("1000000 tries of the wrong type", timer.getMicroseconds());
+	NGF_CHECK(missed == 1000000);
+}
@@ -0,0 +1,170 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  RequestTests.cpp
+ *
+ *    Description:  Requests: replies now and later, callbacks, releasing and stale
+ *                  tickets.
+ *
+ *         Author:  Nikhilesh (nikki)
+ *
+ * =====================================================================================
+ */
+
+#include "NgfTest.h"
+
+#include "boost/thread/thread.hpp"
+
+using namespace NGF;
+
+namespace {
+
+struct MsgFindPath : public TypedMessage<MsgFindPath>
+{
+	int from, to;
+
+	MsgFindPath(int a, int b) : from(a), to(b) { }
+};
+struct MsgGetHealth : public TypedMessage<MsgGetHealth> { };
+
+//Answers MsgFindPath later, MsgGetHealth right away.
+struct Pathfinder : public GameObject
+{
+	std::vector<std::pair<RequestTicket, int> > work;
+
+	NGF_TEST_CONSTRUCTOR(Pathfinder) { }
+
+	void find(const MsgFindPath &msg) 
+	{ 
+		work.push_back(std::make_pair(GameObjectManager::getSingleton().deferReply(), msg.to - msg.from)); 
+	}
+
+	int health(const MsgGetHealth &) { return 10; }
+
+	//Can be run on another thread.
+	void solve()
+	{
+		for (unsigned int i = 0; i < work.size(); ++i)
+		{
+			GameObjectManager::getSingleton().fulfilRequest(work[i].first, MessageReply(work[i].second * 2));
+		}
+	}
+};
+
+struct Agent : public GameObject
+{
+	int got, calls;
+	ReplyStatus last;
+
+	NGF_TEST_CONSTRUCTOR(Agent), got(0), calls(0), last(REPLY_PENDING) { }
+
+	void onReply(RequestTicket, ReplyStatus status, const MessageReply &reply)
+	{
+		++calls;
+		last = status;
+		if (status == REPLY_OK)
+		{
+			got = reply.get<int>();
+		}
+	}
+};
+
+Pathfinder *createPathfinder()
+{
+	GameObjectFactory::getSingleton().registerObjectType<Pathfinder>("Pathfinder")
+		.onMessage<MsgFindPath>(&Pathfinder::find)
+		.onMessage<MsgGetHealth>(&Pathfinder::health);
+	return (Pathfinder *) GameObjectManager::getSingleton().createObject("Pathfinder", Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+}
+
+}
+
+NGF_TEST(requestPolled)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	Pathfinder *pf = createPathfinder();
+
+	RequestTicket ticket = mgr.requestReply(pf, MsgGetHealth());
+	NGF_CHECK(mgr.getRequestStatus(ticket) == REPLY_PENDING);
+	mgr.deliverMessages();
+	NGF_CHECK(mgr.getRequestReply<int>(ticket).get() == 10);
+	NGF_CHECK(mgr.getRequestReply<float>(ticket).status == REPLY_BAD_TYPE);
+
+	//A released ticket is stale, even once its place is used by another request.
+	mgr.releaseRequest(ticket);
+	NGF_CHECK(mgr.getRequestStatus(ticket) == REPLY_UNKNOWN);
+	RequestTicket next = mgr.requestReply(pf, MsgGetHealth());
+	NGF_CHECK(next.index == ticket.index);
+	NGF_CHECK(mgr.getRequestStatus(ticket) == REPLY_UNKNOWN);
+	NGF_CHECK(mgr.getRequestStatus(next) == REPLY_PENDING);
+	mgr.releaseRequest(ticket);
+	NGF_CHECK(mgr.getRequestStatus(next) == REPLY_PENDING);
+	mgr.releaseRequest(next);
+}
+
+NGF_TEST(requestDeferred)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	Pathfinder *pf = createPathfinder();
+	Agent *a = (Agent *) mgr.createObject<Agent>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+	Agent *b = (Agent *) mgr.createObject<Agent>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+
+	mgr.requestReply(pf, MsgFindPath(1, 4), fastdelegate::MakeDelegate(a, &Agent::onReply), a);
+	mgr.requestReply(pf, MsgFindPath(1, 9), fastdelegate::MakeDelegate(b, &Agent::onReply), b);
+	mgr.deliverMessages();
+	NGF_CHECK(pf->work.size() == 2 && a->calls == 0);
+
+	//Fulfilled on another thread, the callbacks come on the next tick. 'b' is gone by
+	//then, so doesn't get one.
+	boost::thread worker(&Pathfinder::solve, pf);
+	worker.join();
+	mgr.destroyObject(b->getID());
+	NGF_CHECK(a->calls == 0);
+	mgr.tick(false, NGFTest::frameEvent(0.1f));
+	NGF_CHECK(a->calls == 1 && a->last == REPLY_OK && a->got == 6);
+
+	//The requests were released after their callbacks, fulfilling them again does nothing.
+	NGF_CHECK(mgr.getRequestStatus(pf->work[0].first) == REPLY_UNKNOWN);
+	pf->solve();
+	mgr.tick(false, NGFTest::frameEvent(0.1f));
+	NGF_CHECK(a->calls == 1);
+}
+
+NGF_TEST(requestFailures)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	Pathfinder *pf = createPathfinder();
+	Agent *a = (Agent *) mgr.createObject<Agent>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+	Agent *c = (Agent *) mgr.createObject<Agent>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+
+	//No reply.
+	mgr.requestReply(c, Message("what"), fastdelegate::MakeDelegate(a, &Agent::onReply), a);
+	mgr.tick(false, NGFTest::frameEvent(0.1f));
+	NGF_CHECK(a->calls == 1 && a->last == REPLY_NONE);
+
+	//Receiver gone before delivery.
+	RequestTicket ticket = mgr.requestReply(c, Message("what"));
+	mgr.destroyObject(c->getID());
+	mgr.tick(false, NGFTest::frameEvent(0.1f));
+	NGF_CHECK(mgr.getRequestStatus(ticket) == REPLY_NO_OBJECT);
+	mgr.releaseRequest(ticket);
+
+	//Full queue.
+	mgr.setMessageQueueCapacity(1);
+	mgr.postMessage(a, Message("x"));
+	ticket = mgr.requestReply(pf, MsgGetHealth());
+	NGF_CHECK(mgr.getRequestStatus(ticket) == REPLY_DROPPED);
+	mgr.releaseRequest(ticket);
+
+	//Deferring outside of a request's message.
+	bool threw = false;
+	try
+	{
+		mgr.deferReply();
+	}
+	catch (Ogre::Exception &)
+	{
+		threw = true;
+	}
+	NGF_CHECK(threw);
+}
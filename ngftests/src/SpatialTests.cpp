@@ -0,0 +1,112 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  SpatialTests.cpp
+ *
+ *    Description:  Nearest-neighbour queries against a brute-force search, including
+ *                  positions past the edge of the spatial hash.
+ *
+ *         Author:  Nikhilesh (nikki)
+ *
+ * =====================================================================================
+ */
+
+#include "NgfTest.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace NGF;
+
+namespace {
+
+struct Dot : public GameObject
+{
+	NGF_TEST_CONSTRUCTOR(Dot) {}
+};
+
+Ogre::Real random(Ogre::Real range)
+{
+	return (std::rand() / Ogre::Real(RAND_MAX) - 0.5f) * 2 * range;
+}
+
+//Checks the 'k' nearest to 'center' are as near as the 'k' nearest of 'objs'.
+void checkNearest(const std::vector<GameObject*> &objs, const Ogre::Vector3 &center, unsigned int k)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+
+	std::vector<ID> got;
+	NGF_CHECK(mgr.queryNearest(center, k, got) == k);
+	NGF_CHECK(got.size() == k);
+
+	std::vector<Ogre::Real> all;
+	for (unsigned int i = 0; i < objs.size(); ++i)
+	{
+		all.push_back((mgr.getPosition(objs[i]) - center).squaredLength());
+	}
+	std::sort(all.begin(), all.end());
+
+	for (unsigned int i = 0; i < k; ++i)
+	{
+		NGF_CHECK((mgr.getPosition(mgr.getByID(got[i])) - center).squaredLength() == all[i]);
+	}
+}
+
+}
+
+NGF_TEST(nearestMatchesBruteForce)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	mgr.setTypeOptions<Dot>(TypeOptions().transform());
+	mgr.setSpatialCellSize(1);
+
+	std::srand(14);
+	std::vector<GameObject*> objs;
+	for (unsigned int i = 0; i < 500; ++i)
+	{
+		objs.push_back(mgr.createObject<Dot>(Ogre::Vector3(random(40), random(40), random(40)), Ogre::Quaternion::IDENTITY));
+	}
+
+	//The hash is about a million cells across, so these all share edge cells.
+	for (unsigned int i = 0; i < 100; ++i)
+	{
+		Ogre::Vector3 pos(2e6f + random(50), random(5), random(5));
+		objs.push_back(mgr.createObject<Dot>(pos, Ogre::Quaternion::IDENTITY));
+	}
+	objs.push_back(mgr.createObject<Dot>(Ogre::Vector3(-2e6f, 0, 0), Ogre::Quaternion::IDENTITY));
+
+	for (unsigned int q = 0; q < 50; ++q)
+	{
+		checkNearest(objs, Ogre::Vector3(random(60), random(60), random(60)), 1 + q % 20);
+	}
+
+	checkNearest(objs, Ogre::Vector3(2e6f, 0, 0), 10);
+	checkNearest(objs, Ogre::Vector3(3e6f, 1, -1), 5);
+	checkNearest(objs, Ogre::Vector3(-3e6f, 0, 0), 2);
+	checkNearest(objs, Ogre::Vector3(0, 5e6f, 0), 3);
+	checkNearest(objs, Ogre::Vector3::ZERO, objs.size());
+}
+
+//Queries a way off a crowd of GameObjects in a fine hash, so they go through many
+//empty rings before finding anything.
+NGF_BENCH(nearestFromAfar)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	mgr.setTypeOptions<Dot>(TypeOptions().transform());
+	mgr.setSpatialCellSize(1);
+
+	std::srand(14);
+	for (unsigned int i = 0; i < 20000; ++i)
+	{
+		mgr.createObject<Dot>(Ogre::Vector3(random(30), random(30), random(30)), Ogre::Quaternion::IDENTITY);
+	}
+
+	std::vector<ID> result;
+	Ogre::Timer timer;
+	for (unsigned int q = 0; q < 1000; ++q)
+	{
+		result.clear();
+		mgr.queryNearest(Ogre::Vector3(43 + random(3), random(30), random(30)), 1, result);
+	}
+	NGFTest::report("1000 nearest queries from 13 cells off", timer.getMicroseconds());
+}
@@ -0,0 +1,129 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  SpawnTests.cpp
+ *
+ *    Description:  Creating GameObjects in batches: unregistered types, names checked
+ *                  before anything is created, and a creation failing partway through.
+ *
+ *         Author:  Nikhilesh (nikki)
+ *
+ * =====================================================================================
+ */
+
+#include "NgfTest.h"
+
+using namespace NGF;
+
+namespace {
+
+struct Crate : public GameObject
+{
+	NGF_TEST_CONSTRUCTOR(Crate) { }
+};
+
+//Fails in its constructor.
+struct Mimic : public GameObject
+{
+	NGF_TEST_CONSTRUCTOR(Mimic)
+	{
+		OGRE_EXCEPT(Ogre::Exception::ERR_INVALIDPARAMS, "Failing on purpose", "Mimic::Mimic()");
+	}
+};
+
+ObjectSpawn spawn(const Ogre::String &type, const Ogre::String &name = "")
+{
+	return ObjectSpawn(type, Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY, PropertyList(), name);
+}
+
+}
+
+NGF_TEST(spawnBatch)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	NGF_REGISTER_OBJECT_TYPE(Crate);
+
+	std::vector<ObjectSpawn> spawns;
+	spawns.push_back(spawn("Crate", "first"));
+	spawns.push_back(spawn("Barrel", "barrel"));
+	spawns.push_back(spawn("Crate"));
+	spawns.push_back(spawn("Crate", "noname"));
+	spawns.push_back(spawn("Crate", "last"));
+
+	//In order, with NULL for types that aren't registered.
+	std::vector<GameObject*> created = mgr.createObjects(spawns);
+	NGF_CHECK(created.size() == 5);
+	NGF_CHECK(created[0] == mgr.getByName("first") && !created[1] && created[4] == mgr.getByName("last"));
+	NGF_CHECK(created[2] && created[3] && created[3]->getName() == "");
+	NGF_CHECK(!mgr.getByName("barrel"));
+	NGF_CHECK(mgr.getNumObjects() == 4);
+	for (unsigned int i = 0; i < created.size(); ++i)
+	{
+		NGF_CHECK(!created[i] || mgr.getByID(created[i]->getID()) == created[i]);
+	}
+
+	NGF_CHECK(mgr.createObjects(std::vector<ObjectSpawn>()).empty());
+}
+
+NGF_TEST(spawnNamesCheckedFirst)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	NGF_REGISTER_OBJECT_TYPE(Crate);
+	mgr.createObject("Crate", Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY, PropertyList(), "taken");
+
+	//A name taken by a GameObject that exists stops the whole batch, even after good ones.
+	std::vector<ObjectSpawn> spawns;
+	spawns.push_back(spawn("Crate", "a"));
+	spawns.push_back(spawn("Crate"));
+	spawns.push_back(spawn("Crate", "taken"));
+	bool threw = false;
+	try
+	{
+		mgr.createObjects(spawns);
+	}
+	catch (Ogre::Exception &)
+	{
+		threw = true;
+	}
+	NGF_CHECK(threw);
+	NGF_CHECK(mgr.getNumObjects() == 1 && !mgr.getByName("a"));
+
+	//The names checked before aren't kept as used.
+	spawns.back() = spawn("Crate", "b");
+	std::vector<GameObject*> created = mgr.createObjects(spawns);
+	NGF_CHECK(created.size() == 3 && mgr.getNumObjects() == 4);
+	NGF_CHECK(mgr.getByName("a") == created[0] && mgr.getByName("b") == created[2]);
+}
+
+NGF_TEST(spawnFailsPartway)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	NGF_REGISTER_OBJECT_TYPE(Crate);
+	NGF_REGISTER_OBJECT_TYPE(Mimic);
+
+	std::vector<ObjectSpawn> spawns;
+	spawns.push_back(spawn("Crate", "before"));
+	spawns.push_back(spawn("Mimic", "mimic"));
+	spawns.push_back(spawn("Crate", "after"));
+
+	//The ones before the failure stay, the rest aren't created.
+	bool threw = false;
+	try
+	{
+		mgr.createObjects(spawns);
+	}
+	catch (Ogre::Exception &)
+	{
+		threw = true;
+	}
+	NGF_CHECK(threw);
+	NGF_CHECK(mgr.getNumObjects() == 1 && mgr.getByName("before"));
+	NGF_CHECK(!mgr.getByName("mimic") && !mgr.getByName("after"));
+
+	//Nothing of the failed part is left holding names.
+	spawns.erase(spawns.begin(), spawns.begin() + 2);
+	spawns.push_back(spawn("Crate", "mimic"));
+	std::vector<GameObject*> created = mgr.createObjects(spawns);
+	NGF_CHECK(created.size() == 2 && mgr.getNumObjects() == 3);
+	NGF_CHECK(mgr.getByName("after") == created[0] && mgr.getByName("mimic") == created[1]);
+}
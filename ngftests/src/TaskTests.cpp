@@ -0,0 +1,247 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  TaskTests.cpp
+ *
+ *    Description:  Scheduled tasks: firing times through all the levels of the timing
+ *                  wheel, and cancelling.
+ *
+ *         Author:  Nikhilesh (nikki)
+ *
+ * =====================================================================================
+ */
+
+#include "NgfTest.h"
+
+#include <cstdlib>
+#include <map>
+
+using namespace NGF;
+
+namespace {
+
+//Notes when each task fires, by the number it was given.
+struct Recorder
+{
+	std::map<std::pair<unsigned int, unsigned int>, int> numbers;
+	std::vector<std::pair<int, double> > fired;
+	std::vector<TaskHandle> cancelOnFire;
+	double now;
+
+	Recorder() : now(0) { }
+
+	TaskHandle schedule(double delay, int number, GameObject *owner = 0)
+	{
+		TaskHandle task = GameObjectManager::getSingleton().scheduleTask((Ogre::Real) delay, 
+			fastdelegate::MakeDelegate(this, &Recorder::fire), owner);
+		numbers[std::make_pair(task.index, task.generation)] = number;
+		return task;
+	}
+
+	void fire(TaskHandle task)
+	{
+		fired.push_back(std::make_pair(numbers[std::make_pair(task.index, task.generation)], now));
+		for (unsigned int i = 0; i < cancelOnFire.size(); ++i)
+		{
+			GameObjectManager::getSingleton().cancelTask(cancelOnFire[i]);
+		}
+		cancelOnFire.clear();
+	}
+};
+
+struct Owner : public GameObject
+{
+	NGF_TEST_CONSTRUCTOR(Owner) { }
+};
+
+//Schedules a task it owns and then fails, in the constructor or, when recycled, on reuse
+//if asked to.
+struct FailingOwner : public GameObject
+{
+	static Recorder *recorder;
+	static bool failReuse;
+
+	NGF_TEST_CONSTRUCTOR(FailingOwner)
+	{
+		recorder->schedule(0.1, 1, this);
+		if (!failReuse)
+		{
+			OGRE_EXCEPT(Ogre::Exception::ERR_INVALIDPARAMS, "Failing on purpose", "FailingOwner::FailingOwner()");
+		}
+	}
+
+	void reactivate(Ogre::Vector3 pos, Ogre::Quaternion rot, PropertyList properties)
+	{
+		recorder->schedule(0.1, 2, this);
+		OGRE_EXCEPT(Ogre::Exception::ERR_INVALIDPARAMS, "Failing on purpose", "FailingOwner::reactivate()");
+	}
+};
+Recorder *FailingOwner::recorder = 0;
+bool FailingOwner::failReuse = false;
+
+}
+
+NGF_TEST(taskWheelCascade)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	Recorder recorder;
+
+	//Mostly short delays, some long enough to start out on the outer levels.
+	std::srand(23);
+	std::map<int, double> due;
+	std::vector<TaskHandle> tasks;
+	for (int i = 0; i < 2000; ++i)
+	{
+		double delay = std::rand() % 5 == 0 ? (std::rand() % 200000) * 0.37 : (std::rand() % 1000) * 0.013;
+		tasks.push_back(recorder.schedule(delay, i));
+		due[i] = delay;
+	}
+	NGF_CHECK(mgr.getNumTasks() == 2000);
+
+	for (int i = 0; i < 2000; i += 7)
+	{
+		NGF_CHECK(mgr.cancelTask(tasks[i]));
+		NGF_CHECK(!mgr.cancelTask(tasks[i]));
+		NGF_CHECK(!mgr.isTaskPending(tasks[i]));
+		due.erase(i);
+	}
+	NGF_CHECK(mgr.getNumTasks() == due.size());
+
+	//Steps short and long, so tasks both cascade down and get jumped over.
+	while (mgr.getNumTasks() && recorder.now < 80000)
+	{
+		double step = std::rand() % 4 == 0 ? 37.3 : 0.016;
+		recorder.now += step;
+		mgr.advanceTasks((Ogre::Real) step);
+	}
+	NGF_CHECK(mgr.getNumTasks() == 0);
+	NGF_CHECK(recorder.fired.size() == due.size());
+
+	//None early (allowing for float error in the long delays), and in the order due to
+	//within a step.
+	const double resolution = mgr.getTaskResolution();
+	double lastDue = -1;
+	for (unsigned int i = 0; i < recorder.fired.size(); ++i)
+	{
+		double delay = due[recorder.fired[i].first];
+		NGF_CHECK(recorder.fired[i].second + 1e-3 * (1 + delay * 1e-4) >= delay);
+		NGF_CHECK(delay >= lastDue - resolution - 1e-3);
+		lastDue = std::max(lastDue, delay);
+	}
+}
+
+NGF_TEST(taskCancelling)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	Recorder recorder;
+	GameObject *owner = mgr.createObject<Owner>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+
+	TaskHandle owned = recorder.schedule(0.5, 1, owner);
+	TaskHandle alsoOwned = recorder.schedule(0.5, 2, owner);
+	TaskHandle first = recorder.schedule(0.5, 3);
+	TaskHandle second = recorder.schedule(0.5, 4);
+	NGF_CHECK(mgr.isTaskPending(owned) && mgr.getTaskTimeLeft(owned) > 0.49f);
+
+	//Destroying the owner cancels its tasks.
+	mgr.destroyObject(owner->getID());
+	NGF_CHECK(!mgr.isTaskPending(owned) && !mgr.isTaskPending(alsoOwned));
+	NGF_CHECK(mgr.getTaskTimeLeft(owned) == -1);
+	NGF_CHECK(mgr.isTaskPending(first) && mgr.isTaskPending(second));
+
+	//A task cancelling another due in the same step.
+	recorder.cancelOnFire.push_back(second);
+
+	//Paused time doesn't count.
+	mgr.tick(true, NGFTest::frameEvent(0.25f));
+	NGF_CHECK(recorder.fired.empty());
+	for (unsigned int i = 0; i < 3; ++i)
+	{
+		mgr.tick(false, NGFTest::frameEvent(0.25f));
+	}
+	NGF_CHECK(recorder.fired.size() == 1 && recorder.fired[0].first == 3);
+	NGF_CHECK(mgr.getNumTasks() == 0);
+
+	//Handles of fired tasks go stale, even once their place is reused.
+	TaskHandle reused = recorder.schedule(1, 5);
+	NGF_CHECK(!mgr.isTaskPending(first) && !mgr.cancelTask(first));
+	NGF_CHECK(mgr.isTaskPending(reused));
+
+	bool threw = false;
+	try
+	{
+		mgr.setTaskResolution(0);
+	}
+	catch (Ogre::Exception &)
+	{
+		threw = true;
+	}
+	NGF_CHECK(threw);
+}
+
+NGF_TEST(taskOwnerFailedCreation)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	Recorder recorder;
+	FailingOwner::recorder = &recorder;
+
+	//Failing in the constructor.
+	FailingOwner::failReuse = false;
+	bool threw = false;
+	try
+	{
+		mgr.createObject<FailingOwner>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+	}
+	catch (Ogre::Exception &)
+	{
+		threw = true;
+	}
+	NGF_CHECK(threw);
+	NGF_CHECK(mgr.getNumTasks() == 0);
+
+	//Failing when reused. The first one is made fine and its task goes with it.
+	mgr.setTypeOptions<FailingOwner>(TypeOptions().recycle(4));
+	FailingOwner::failReuse = true;
+	mgr.destroyObject(mgr.createObject<FailingOwner>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY)->getID());
+	NGF_CHECK(mgr.getNumTasks() == 0);
+	threw = false;
+	try
+	{
+		mgr.createObject<FailingOwner>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+	}
+	catch (Ogre::Exception &)
+	{
+		threw = true;
+	}
+	NGF_CHECK(threw);
+	NGF_CHECK(mgr.getNumTasks() == 0);
+
+	mgr.advanceTasks(1);
+	NGF_CHECK(recorder.fired.empty());
+	NGF_CHECK(mgr.getNumObjects() == 0);
+}
+
+//Lots of short tasks scheduled, half cancelled, the rest fired.
+NGF_BENCH(taskChurn)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	Recorder recorder;
+	TaskFunction func = fastdelegate::MakeDelegate(&recorder, &Recorder::fire);
+
+	std::srand(23);
+	std::vector<TaskHandle> tasks;
+	Ogre::Timer timer;
+	for (unsigned int frame = 0; frame < 1000; ++frame)
+	{
+		tasks.clear();
+		for (unsigned int i = 0; i < 200; ++i)
+		{
+			tasks.push_back(mgr.scheduleTask((std::rand() % 300) * 0.01f, func));
+		}
+		for (unsigned int i = 0; i < tasks.size(); i += 2)
+		{
+			mgr.cancelTask(tasks[i]);
+		}
+		mgr.advanceTasks(0.016f);
+	}
+	NGFTest::report("1000 frames of 200 tasks, half cancelled", timer.getMicroseconds());
+}
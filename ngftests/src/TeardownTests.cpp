@@ -0,0 +1,137 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  TeardownTests.cpp
+ *
+ *    Description:  destroyAll and World changes: persistent GameObjects, listeners, and
+ *                  how long tearing down a big level takes.
+ *
+ *         Author:  Nikhilesh (nikki)
+ *
+ * =====================================================================================
+ */
+
+#include "NgfTest.h"
+
+using namespace NGF;
+
+namespace {
+
+struct Thing : public GameObject
+{
+	static int numAlive;
+	static int numTicks;
+
+	NGF_TEST_CONSTRUCTOR(Thing) { ++numAlive; }
+	~Thing() { --numAlive; }
+
+	void unpausedTick(const Ogre::FrameEvent &) { ++numTicks; }
+};
+int Thing::numAlive = 0;
+int Thing::numTicks = 0;
+
+struct Listener
+{
+	unsigned int numDestroyed;
+
+	void destroyingAll(const std::vector<GameObject*> &objs) { numDestroyed += objs.size(); }
+};
+
+//Fills the level with GameObjects, one in 'keepEvery' persistent, and clears it when
+//it stops.
+class Level : public World
+{
+	unsigned int mNumObjects;
+	unsigned int mKeepEvery;
+
+public:
+	Level(unsigned int numObjects, unsigned int keepEvery)
+	    : mNumObjects(numObjects), mKeepEvery(keepEvery)
+	{
+	}
+
+	void init()
+	{
+		GameObjectManager &mgr = GameObjectManager::getSingleton();
+
+		for (unsigned int i = 0; i < mNumObjects; ++i)
+		{
+			GameObject *obj = mgr.createObject<Thing>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY, 
+					PropertyList(), "thing" + Ogre::StringConverter::toString(i));
+			obj->addFlag("Thing");
+			if (i % mKeepEvery == 0)
+			{
+				obj->setPersistent(true);
+			}
+		}
+	}
+
+	void stop()
+	{
+		GameObjectManager::getSingleton().destroyAll();
+	}
+};
+
+class Empty : public World
+{
+};
+
+//Lets go of the persistent GameObjects, so the GameObjectManager can be deleted.
+struct Forgetter
+{
+	void forget(GameObject *obj) { obj->setPersistent(false); }
+
+	static void forgetAll()
+	{
+		Forgetter forgetter;
+		GameObjectManager::getSingleton().forEachGameObject(
+			GameObjectManager::ForEachFunction(&forgetter, &Forgetter::forget));
+	}
+};
+
+}
+
+NGF_TEST(destroyAllKeepsPersistent)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	//Outlives the test, the GameObjectManager calls it once more when it's deleted.
+	static Listener listener;
+	listener.numDestroyed = 0;
+	mgr.addDestroyAllListener(GameObjectManager::DestroyAllFunction(&listener, &Listener::destroyingAll));
+
+	Thing::numAlive = 0;
+	Thing::numTicks = 0;
+	Level level(1000, 100);
+	level.init();
+	GameObject *kept = mgr.getByName("thing100");
+
+	level.stop();
+	NGF_CHECK(Thing::numAlive == 10 && mgr.getNumObjects() == 10);
+	NGF_CHECK(listener.numDestroyed == 990);
+	NGF_CHECK(mgr.getByName("thing100") == kept && !mgr.getByName("thing1"));
+
+	//What's left still ticks, and the names and slots can be used again.
+	mgr.tick(false, NGFTest::frameEvent(0.1f));
+	NGF_CHECK(Thing::numTicks == 10);
+	NGF_CHECK(mgr.createObject<Thing>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY, PropertyList(), "thing1"));
+
+	Forgetter::forgetAll();
+	mgr.destroyAll();
+	NGF_CHECK(Thing::numAlive == 0 && listener.numDestroyed == 1001);
+}
+
+NGF_BENCH(nextWorldTeardown)
+{
+	WorldManager worlds;
+	worlds.addWorld(new Level(100000, 1000));
+	worlds.addWorld(new Empty());
+	worlds.start(0);
+
+	//Stopping the level is the teardown, the next World does nothing.
+	Ogre::Timer timer;
+	worlds.nextWorld();
+	NGFTest::report("nextWorld, 100k GameObjects, 100 persistent", timer.getMicroseconds());
+
+	NGF_CHECK(GameObjectManager::getSingleton().getNumObjects() == 100);
+	Forgetter::forgetAll();
+}
@@ -0,0 +1,164 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  TickTests.cpp
+ *
+ *    Description:  Ticking: parallel ticks and their recorded commands, and ticks that
+ *                  throw.
+ *
+ *         Author:  Nikhilesh (nikki)
+ *
+ * =====================================================================================
+ */
+
+#include "NgfTest.h"
+
+using namespace NGF;
+
+namespace {
+
+std::vector<int> received;
+
+struct Sink : public GameObject
+{
+	NGF_TEST_CONSTRUCTOR(Sink) { setTickFlags(TICK_NONE); }
+
+	MessageReply receiveMessage(const Message &msg)
+	{
+		received.push_back(msg.getParam<int>(0));
+		return MessageReply();
+	}
+};
+
+//Sends its number to a Sink, and every few frames creates or destroys.
+struct Worker : public GameObject
+{
+	static ID sink;
+	int number;
+
+	NGF_TEST_CONSTRUCTOR(Worker), number(0) { }
+
+	void unpausedTick(const Ogre::FrameEvent &)
+	{
+		GameObjectManager &mgr = GameObjectManager::getSingleton();
+		mgr.sendMessage(mgr.getByID(sink), (Message("number"), number));
+
+		if (number % 10 == 0)
+		{
+			mgr.createObject<Sink>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+		}
+		if (number % 7 == 0)
+		{
+			mgr.requestDestroy(getID());
+		}
+	}
+};
+ID Worker::sink = 0;
+
+struct Thrower : public GameObject
+{
+	static bool armed;
+
+	NGF_TEST_CONSTRUCTOR(Thrower) { }
+
+	void unpausedTick(const Ogre::FrameEvent &)
+	{
+		if (armed)
+		{
+			GameObjectManager::getSingleton().destroyObject(getID());
+			OGRE_EXCEPT(Ogre::Exception::ERR_INVALID_STATE, "Throwing on purpose", "Thrower::unpausedTick()");
+		}
+	}
+};
+bool Thrower::armed = false;
+
+}
+
+NGF_TEST(parallelCommandOrder)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	mgr.setTypeOptions<Worker>(TypeOptions().parallel());
+	mgr.setTickThreads(4, 8);
+
+	received.clear();
+	Worker::sink = mgr.createObject<Sink>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY)->getID();
+	const int num = 1000;
+	for (int i = 0; i < num; ++i)
+	{
+		((Worker *) mgr.createObject<Worker>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY))->number = i;
+	}
+
+	//Everything recorded happens in the order a serial tick would have done it, here the
+	//order of creation.
+	mgr.tick(false, NGFTest::frameEvent(0.1f));
+	NGF_CHECK(received.size() == num);
+	for (int i = 0; i < num; ++i)
+	{
+		NGF_CHECK(received[i] == i);
+	}
+
+	//The destroyed Workers are gone after the frame, new Sinks are there.
+	for (unsigned int frame = 1; frame < 3; ++frame)
+	{
+		received.clear();
+		mgr.tick(false, NGFTest::frameEvent(0.1f));
+		NGF_CHECK(received.size() == num - num / 7 - 1);
+	}
+	//The Sink, the Workers left, 100 Sinks from the first frame and 85 from each after
+	//(multiples of 70 are gone).
+	NGF_CHECK(mgr.getNumObjects() == 1 + (num - num / 7 - 1) + 100 + 2 * 85);
+}
+
+NGF_TEST(throwingTick)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+	for (unsigned int i = 0; i < 3; ++i)
+	{
+		mgr.createObject<Thrower>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+	}
+
+	Thrower::armed = true;
+	bool thrown = false;
+	try
+	{
+		mgr.tick(false, NGFTest::frameEvent(0.1f));
+	}
+	catch (const Ogre::Exception &)
+	{
+		thrown = true;
+	}
+	NGF_CHECK(thrown);
+	NGF_CHECK(mgr.getNumObjects() == 2);
+
+	//The tick loop was left, so the lists can be changed right away again.
+	Thrower::armed = false;
+	GameObject *obj = mgr.createObject<Thrower>(Ogre::Vector3::ZERO, Ogre::Quaternion::IDENTITY);
+	NGF_CHECK(mgr.destroyObject(obj->getID()));
+	NGF_CHECK(mgr.getNumObjects() == 2);
+	mgr.tick(false, NGFTest::frameEvent(0.1f));
+}
+
+NGF_TEST(fixedTimeStep)
+{
+	GameObjectManager &mgr = GameObjectManager::getSingleton();
+
+	bool thrown = false;
+	try
+	{
+		mgr.setFixedTimeStep(0.02f, 0);
+	}
+	catch (const Ogre::Exception &)
+	{
+		thrown = true;
+	}
+	NGF_CHECK(thrown);
+
+	//Three steps fit, the rest carries over.
+	mgr.setFixedTimeStep(0.02f, 5);
+	mgr.tick(false, NGFTest::frameEvent(0.07f));
+	NGF_CHECK(mgr.getInterpolationAlpha() > 0.49f && mgr.getInterpolationAlpha() < 0.51f);
+
+	//Too slow, only five steps are done and the rest is dropped.
+	mgr.tick(false, NGFTest::frameEvent(1.0f));
+	NGF_CHECK(mgr.getInterpolationAlpha() < 0.01f);
+}
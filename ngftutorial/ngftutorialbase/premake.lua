@@ -56,6 +56,8 @@ if (linux) then
     "`pkg-config OGRE --libs`" ..
     "`pkg-config OIS --libs`"
     }
+
+    table.insert(package.links, "boost_thread")                         -- NGF uses Boost.Thread.
 end
 
 -- Files ------------------------------------------------------------------------------------
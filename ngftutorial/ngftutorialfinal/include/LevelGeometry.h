@@ -38,7 +38,7 @@ class LevelGeometry : public NGF::GameObject
 	{
 	}
 
-        NGF::MessageReply receiveMessage(NGF::Message msg)
+        NGF::MessageReply receiveMessage(const NGF::Message &msg)
 	{
 	}
 };
@@ -59,7 +59,7 @@ class Player : public NGF::GameObject
 	{
 	}
 
-        NGF::MessageReply receiveMessage(NGF::Message msg)
+        NGF::MessageReply receiveMessage(const NGF::Message &msg)
 	{
 	}
 };